@@ -0,0 +1,677 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Benchmarks for the game engine.
+//
+// Runs as an ordinary QtTest executable, and accepts every QtTest option.  In
+// addition, `-json <file>` writes each benchmark result to <file> as a JSON
+// array, for tracking regressions between releases:
+//
+//   mines_bench -json results.json
+//   mines_bench generation -json results.json
+
+#include "endless.h"
+#include "gameboard.h"
+#include "gamestate.h"
+#include "montecarlo.h"
+#include "neighborcount.h"
+#include "noguess.h"
+#include "probability.h"
+#include "recording.h"
+#include "rng.h"
+#include "savegame.h"
+#include "solver.h"
+#include "statslog.h"
+#include "strategy.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTemporaryFile>
+#include <QTest>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace {
+
+constexpr std::uint64_t kSeed = 0x5eed;
+
+void addBoards()
+{
+    QTest::addColumn<GameBoard>("board");
+
+    QTest::newRow("small") << kSmallGame;
+    QTest::newRow("medium") << kMediumGame;
+    QTest::newRow("large") << kLargeGame;
+    QTest::newRow("custom-75x75") << GameBoard{75, 75, 1000};
+    QTest::newRow("custom-500x500") << GameBoard{500, 500, 40000};
+    QTest::newRow("custom-2000x2000") << GameBoard{2000, 2000, 640000};
+}
+
+std::vector<std::uint8_t> minePlane(const GameState& state)
+{
+    std::vector<std::uint8_t> mines(state.size());
+    for (int ix = 0; ix < state.size(); ++ix)
+    {
+        mines[ix] = state.isMine(ix) ? 1 : 0;
+    }
+    return mines;
+}
+
+// Reveals the first cell and then every cell the solver proves safe, until
+// it has nothing more to offer, which is when a player would turn to
+// probabilities.
+void revealProvablySafe(GameState& state, Solver& solver)
+{
+    solver.update(state.revealArea(0));
+
+    for (std::vector<int> safe = solver.safeCells(); !safe.empty(); safe = solver.safeCells())
+    {
+        solver.update(state.revealCells(safe));
+    }
+}
+
+} // namespace
+
+class EngineBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void generation_data() { addBoards(); }
+    void generation();
+
+    void noGuessGeneration_data();
+    void noGuessGeneration();
+
+    void endlessChunks();
+
+    void statsLoad();
+
+    void neighborCount_data() { addBoards(); }
+    void neighborCount();
+
+    void floodFill_data() { addBoards(); }
+    void floodFill();
+
+    void singleReveals_data() { addBoards(); }
+    void singleReveals();
+
+    void batchReveal_data() { addBoards(); }
+    void batchReveal();
+
+    void gameOver_data() { addBoards(); }
+    void gameOver();
+
+    void solveOpening_data() { addBoards(); }
+    void solveOpening();
+
+    void solverUpdate_data() { addBoards(); }
+    void solverUpdate();
+
+    void frontier_data() { addBoards(); }
+    void frontier();
+
+    void saveGame_data() { addBoards(); }
+    void saveGame();
+
+    void replayVerify_data() { addBoards(); }
+    void replayVerify();
+
+    void probabilities_data() { addBoards(); }
+    void probabilities();
+
+    void probabilityCache_data() { addBoards(); }
+    void probabilityCache();
+
+    void monteCarlo_data() { addBoards(); }
+    void monteCarlo();
+};
+
+void EngineBench::generation()
+{
+    QFETCH(GameBoard, board);
+
+    std::uint64_t seed = kSeed;
+    QBENCHMARK {
+        GameState state{board, seed++};
+        Q_UNUSED(state);
+    }
+}
+
+void EngineBench::noGuessGeneration_data()
+{
+    // Only the standard sizes: on the larger custom boards, a layout that can
+    // be cleared without guessing from a corner is too rare to wait for.
+    QTest::addColumn<GameBoard>("board");
+
+    QTest::newRow("small") << kSmallGame;
+    QTest::newRow("medium") << kMediumGame;
+    QTest::newRow("large") << kLargeGame;
+}
+
+void EngineBench::noGuessGeneration()
+{
+    QFETCH(GameBoard, board);
+
+    const NoGuessGenerator generator;
+
+    std::uint64_t seed = kSeed;
+    QBENCHMARK {
+        const NoGuessGenerator::Result result = generator.generate(board, seed++);
+        QVERIFY(result.state.has_value());
+        QVERIFY(NoGuessGenerator::isSolvableFrom(*result.state, NoGuessGenerator::startCell()));
+    }
+}
+
+void EngineBench::endlessChunks()
+{
+    // Flag one cell in each of 256 chunks in a row, which generates every
+    // one of them, with a budget small enough that most are compressed and
+    // then evicted down to their one flag.
+    constexpr qsizetype kBudget = qsizetype{64} << 10;
+    QBENCHMARK {
+        EndlessWorld world{kSeed, 0.18, kBudget};
+        for (int chunk = 0; chunk < 256; ++chunk)
+        {
+            world.toggleFlag(QPoint{chunk * EndlessWorld::kChunkSize, 0});
+        }
+        QCOMPARE(world.storedChunks(), 256);
+        QVERIFY(world.storedBytes() <= kBudget);
+        QVERIFY(world.isFlagged(QPoint{0, 0}));
+    }
+}
+
+void EngineBench::statsLoad()
+{
+    // Rebuild the totals from a log of 100,000 games, as startup does.
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.close();
+
+    Rng rng{kSeed};
+    {
+        StatsLog log{file.fileName()};
+        QVERIFY(log.load());
+        for (int ix = 0; ix < 100000; ++ix)
+        {
+            const GameBoard board = ix % 3 == 0 ? kSmallGame : ix % 3 == 1 ? kMediumGame : kLargeGame;
+            log.append(StatsLog::Game{board, rng(), rng.bounded(2) == 0, rng.bounded(1000000000), 100, 50, ix});
+        }
+    }
+
+    QBENCHMARK {
+        StatsLog log{file.fileName()};
+        QVERIFY(log.load());
+        QCOMPARE(log.allStats().size(), size_t{3});
+    }
+}
+
+void EngineBench::neighborCount()
+{
+    QFETCH(GameBoard, board);
+
+    const std::vector<std::uint8_t> mines = minePlane(GameState{board, kSeed});
+    std::vector<std::uint8_t> counts(mines.size());
+
+    QBENCHMARK {
+        countNeighboringMines(mines.data(), counts.data(), board.rows(), board.cols());
+    }
+}
+
+void EngineBench::floodFill()
+{
+    QFETCH(GameBoard, board);
+
+    // With no mines at all, revealing a corner opens the entire board.  Each
+    // iteration includes copying the untouched board, which is a single memcpy.
+    const GameState empty{GameBoard{board.rows(), board.cols(), 0}, kSeed};
+
+    QBENCHMARK {
+        GameState state = empty;
+        QCOMPARE(static_cast<int>(state.revealArea(0).size()), state.size());
+    }
+}
+
+void EngineBench::singleReveals()
+{
+    QFETCH(GameBoard, board);
+
+    // Reveal every numbered cell one click at a time, checking for a win after
+    // each, as the UI does.
+    const GameState fresh{board, kSeed};
+
+    std::vector<int> numbered;
+    for (int ix = 0; ix < fresh.size(); ++ix)
+    {
+        if (!fresh.isMine(ix) && fresh.neighboringMines(ix) != 0)
+        {
+            numbered.push_back(ix);
+        }
+    }
+
+    int wins = 0;
+    QBENCHMARK {
+        GameState state = fresh;
+        for (int ix : numbered)
+        {
+            state.revealArea(ix);
+            if (state.isSolved())
+            {
+                ++wins;
+            }
+        }
+    }
+    Q_UNUSED(wins);
+}
+
+void EngineBench::batchReveal()
+{
+    QFETCH(GameBoard, board);
+
+    // The same cells as singleReveals, revealed as one move.
+    const GameState fresh{board, kSeed};
+
+    std::vector<int> numbered;
+    for (int ix = 0; ix < fresh.size(); ++ix)
+    {
+        if (!fresh.isMine(ix) && fresh.neighboringMines(ix) != 0)
+        {
+            numbered.push_back(ix);
+        }
+    }
+
+    QBENCHMARK {
+        GameState state = fresh;
+        QCOMPARE(state.revealCells(numbered).size(), numbered.size());
+    }
+}
+
+void EngineBench::gameOver()
+{
+    QFETCH(GameBoard, board);
+
+    // Step on a mine, then gather every mine on the board to be shown.
+    const GameState fresh{board, kSeed};
+
+    int mine = 0;
+    while (mine < fresh.size() && !fresh.isMine(mine))
+    {
+        ++mine;
+    }
+
+    if (mine == fresh.size())
+    {
+        QSKIP("board has no mines");
+    }
+
+    QBENCHMARK {
+        GameState state = fresh;
+        state.revealArea(mine);
+        QVERIFY(state.isMine(mine));
+
+        std::vector<int> mines;
+        mines.reserve(state.mineCount());
+        for (int ix = 0; ix < state.size(); ++ix)
+        {
+            if (state.isMine(ix))
+            {
+                mines.push_back(ix);
+            }
+        }
+        QCOMPARE(static_cast<int>(mines.size()), state.mineCount());
+    }
+}
+
+void EngineBench::solveOpening()
+{
+    QFETCH(GameBoard, board);
+
+    // Solve from scratch after the first click.
+    GameState state{board, kSeed};
+    state.revealArea(0);
+
+    QBENCHMARK {
+        Solver solver{state};
+        Q_UNUSED(solver);
+    }
+}
+
+void EngineBench::solverUpdate()
+{
+    QFETCH(GameBoard, board);
+
+    // Reveal one provably safe cell and bring the solver up to date, as would
+    // happen after every click.  A reveal can't be undone between iterations,
+    // so each one also solves the opening from scratch; subtract solveOpening
+    // for the cost of the update alone.
+    GameState opened{board, kSeed};
+    opened.revealArea(0);
+
+    const std::vector<int> safe = Solver{opened}.safeCells();
+    if (safe.empty())
+    {
+        QSKIP("the opening leaves no provably safe cell");
+    }
+
+    QBENCHMARK {
+        GameState state = opened;
+        Solver solver{state};
+        solver.update(state.revealArea(safe.front()));
+    }
+}
+
+void EngineBench::frontier()
+{
+    QFETCH(GameBoard, board);
+
+    // Visit the frontier of a part-solved board, as a hint or an overlay
+    // would, after checking it against the rescan it replaces.
+    GameState state{board, kSeed};
+    Solver solver{state};
+    revealProvablySafe(state, solver);
+
+    int rescanned = 0;
+    for (int ix = 0; ix < state.size(); ++ix)
+    {
+        bool bordersNumber = false;
+        state.forEachNeighbor(ix, [&](int n) { bordersNumber |= state.isRevealed(n) && !state.isMine(n); });
+        if (!state.isRevealed(ix) && bordersNumber)
+        {
+            QVERIFY(state.frontier().contains(ix));
+            ++rescanned;
+        }
+    }
+    QCOMPARE(state.frontier().size(), rescanned);
+
+    qint64 total = 0;
+    QBENCHMARK {
+        for (int ix : state.frontier())
+        {
+            total += ix;
+        }
+    }
+    Q_UNUSED(total);
+}
+
+void EngineBench::saveGame()
+{
+    QFETCH(GameBoard, board);
+
+    // Encode a part-solved game and rebuild it, as closing and reopening
+    // the window would, minus the file.
+    GameState state{board, kSeed};
+    Solver solver{state};
+    revealProvablySafe(state, solver);
+
+    QBENCHMARK {
+        const QByteArray bytes = SaveGame::encode(state, 0);
+        const std::optional<SaveGame::Snapshot> snapshot = SaveGame::decode(bytes);
+        QVERIFY(snapshot);
+        QVERIFY(snapshot->state.cells() == state.cells());
+    }
+}
+
+void EngineBench::replayVerify()
+{
+    QFETCH(GameBoard, board);
+
+    // Record the moves of revealProvablySafe() one cell at a time, a
+    // second apart, then check the decoded recording as a leaderboard would.
+    GameState state{board, kSeed};
+    Solver solver{state};
+    Recording recording{board, kSeed};
+
+    qint64 timeUs = 0;
+    recording.append(Recording::Move{Recording::Action::Reveal, 0, timeUs});
+    solver.update(state.revealArea(0));
+    for (std::vector<int> safe = solver.safeCells(); !safe.empty(); safe = solver.safeCells())
+    {
+        for (int ix : safe)
+        {
+            if (!state.isRevealed(ix))
+            {
+                timeUs += 1000000;
+                recording.append(Recording::Move{Recording::Action::Reveal, ix, timeUs});
+                solver.update(state.revealArea(ix));
+            }
+        }
+    }
+
+    const QByteArray bytes = recording.encode();
+    QBENCHMARK {
+        const std::optional<Recording> decoded = Recording::decode(bytes);
+        QVERIFY(decoded);
+        QVERIFY(decoded->verify().valid);
+    }
+}
+
+void EngineBench::probabilities()
+{
+    QFETCH(GameBoard, board);
+
+    GameState state{board, kSeed};
+    Solver solver{state};
+    revealProvablySafe(state, solver);
+
+    // A fresh engine each time, so that its cache doesn't answer every
+    // iteration after the first.
+    ProbabilityEngine::Result result;
+    QBENCHMARK {
+        result = ProbabilityEngine{}.compute(state, &solver);
+    }
+
+    qsizetype largest = 0;
+    for (const auto& component : result.components)
+    {
+        largest = std::max<qsizetype>(largest, component.cells);
+    }
+    qInfo("%lld components, the largest with %lld cells; enumeration took %lld of %lld ns",
+          static_cast<long long>(result.components.size()),
+          static_cast<long long>(largest),
+          static_cast<long long>(result.enumerationNs),
+          static_cast<long long>(result.totalNs));
+}
+
+void EngineBench::probabilityCache()
+{
+    QFETCH(GameBoard, board);
+
+    // Every position of one game, played by the "probability" strategy, with
+    // the probabilities recomputed after each move by a single engine, as
+    // an assistant following the player would.
+    std::vector<GameState> positions;
+    {
+        GameState state{board, kSeed};
+        Solver solver{state};
+        Rng rng{kSeed};
+        const std::unique_ptr<Strategy> strategy = Strategy::create(QStringLiteral("probability"));
+        strategy->newGame();
+
+        while (!state.isSolved())
+        {
+            const int move = strategy->chooseMove(state, solver, rng);
+            const std::vector<int> revealed = state.revealArea(move);
+            if (state.isMine(move))
+            {
+                break;
+            }
+            solver.update(revealed);
+            positions.push_back(state);
+        }
+    }
+
+    ProbabilityEngine::Cache::Stats stats;
+    ProbabilityEngine::PositionCache::Stats positionStats;
+    QBENCHMARK {
+        const ProbabilityEngine engine;
+        for (const GameState& position : positions)
+        {
+            engine.compute(position);
+        }
+        stats = engine.cacheStats();
+        positionStats = engine.positionCacheStats();
+    }
+
+    qInfo("%lld positions; %lld of %lld components found in the cache (%.1f%%), holding %lld KiB",
+          static_cast<long long>(positions.size()),
+          static_cast<long long>(stats.hits),
+          static_cast<long long>(stats.lookups),
+          stats.hitRate() * 100.0,
+          static_cast<long long>(stats.bytes >> 10));
+    qInfo("%lld of %lld positions found in the cache (%.1f%%), holding %lld KiB",
+          static_cast<long long>(positionStats.hits),
+          static_cast<long long>(positionStats.lookups),
+          positionStats.hitRate() * 100.0,
+          static_cast<long long>(positionStats.bytes >> 10));
+}
+
+void EngineBench::monteCarlo()
+{
+    QFETCH(GameBoard, board);
+
+    // The time the estimator takes to narrow every interval to within two
+    // percentage points, from the same position as probabilities().
+    GameState state{board, kSeed};
+    Solver solver{state};
+    revealProvablySafe(state, solver);
+
+    MonteCarloEstimator::Budget budget;
+    budget.timeMs = 10000;
+    budget.maxHalfWidth = 0.02;
+    budget.seed = kSeed;
+    const MonteCarloEstimator estimator{budget};
+
+    MonteCarloEstimator::Result result;
+    QBENCHMARK {
+        result = estimator.estimate(state, &solver);
+    }
+
+    QVERIFY(result.consistent);
+    qInfo("%lld samples in %lld batches on %d threads; %s",
+          static_cast<long long>(result.samples),
+          static_cast<long long>(result.batches),
+          result.threads,
+          result.converged ? "converged" : "ran out of time");
+}
+
+namespace {
+
+// Converts the benchmark results in a QtTest XML log to a JSON array.
+bool writeJson(const QString& xmlPath, const QString& jsonPath)
+{
+    QFile xmlFile{xmlPath};
+    if (!xmlFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QJsonArray results;
+    QString function;
+
+    QXmlStreamReader xml{&xmlFile};
+    while (!xml.atEnd())
+    {
+        if (xml.readNext() != QXmlStreamReader::StartElement)
+        {
+            continue;
+        }
+
+        const auto attrs = xml.attributes();
+        if (xml.name() == QLatin1String("TestFunction"))
+        {
+            function = attrs.value("name").toString();
+        }
+        else if (xml.name() == QLatin1String("BenchmarkResult"))
+        {
+            results.append(QJsonObject{
+                {"benchmark", function},
+                {"board", attrs.value("tag").toString()},
+                {"metric", attrs.value("metric").toString()},
+                {"value", attrs.value("value").toDouble()},
+                {"iterations", attrs.value("iterations").toInt()},
+            });
+        }
+    }
+
+    if (xml.hasError())
+    {
+        return false;
+    }
+
+    QFile jsonFile{jsonPath};
+    if (!jsonFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    jsonFile.write(QJsonDocument{results}.toJson());
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QStringList args = app.arguments();
+    QString jsonPath;
+
+    const qsizetype jsonArg = args.indexOf(QStringLiteral("-json"));
+    if (jsonArg >= 0 && jsonArg + 1 < args.size())
+    {
+        jsonPath = args[jsonArg + 1];
+        args.remove(jsonArg, 2);
+    }
+
+    QTemporaryFile xmlLog;
+    if (!jsonPath.isEmpty())
+    {
+        if (!xmlLog.open())
+        {
+            qCritical("Could not create a temporary file for benchmark results");
+            return 1;
+        }
+        xmlLog.close();
+
+        // Keep the usual human-readable output, alongside XML for conversion.
+        args << QStringLiteral("-o") << QStringLiteral("-,txt")
+             << QStringLiteral("-o") << xmlLog.fileName() + QStringLiteral(",xml");
+    }
+
+    EngineBench bench;
+    int result = QTest::qExec(&bench, args);
+
+    if (!jsonPath.isEmpty() && !writeJson(xmlLog.fileName(), jsonPath))
+    {
+        qCritical("Could not write benchmark results to %s", qPrintable(jsonPath));
+        return result != 0 ? result : 1;
+    }
+
+    return result;
+}
+
+#include "enginebench.moc"
@@ -0,0 +1,101 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CELLSET_H
+#define CELLSET_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/**
+ * @brief A set of cell indices on one board, with constant-time insertion,
+ *        removal and membership tests, iterated in time proportional to its
+ *        size rather than the board's.
+ *
+ * Membership is a dense bitset; the members themselves are kept unordered in
+ * a compact list, with each member's position in the list recorded so that
+ * it can be removed by moving the last member into its place.
+ */
+class CellSet
+{
+public:
+    CellSet() = default;
+
+    explicit CellSet(int cells)
+        : m_bits((static_cast<size_t>(cells) + 63) / 64, 0)
+        , m_slot(static_cast<size_t>(cells), -1)
+    {
+    }
+
+    bool contains(int index) const { return (m_bits[index >> 6] >> (index & 63)) & 1; }
+
+    int size() const { return static_cast<int>(m_members.size()); }
+    bool empty() const { return m_members.empty(); }
+
+    /**
+     * @brief The members, in no particular order.  Invalidated by any change to the set.
+     */
+    std::span<const int> members() const { return m_members; }
+
+    auto begin() const { return m_members.begin(); }
+    auto end() const { return m_members.end(); }
+
+    /**
+     * @return true if the cell was not already a member.
+     */
+    bool insert(int index)
+    {
+        if (contains(index))
+        {
+            return false;
+        }
+
+        m_bits[index >> 6] |= std::uint64_t{1} << (index & 63);
+        m_slot[index] = static_cast<int>(m_members.size());
+        m_members.push_back(index);
+        return true;
+    }
+
+    /**
+     * @return true if the cell was a member.
+     */
+    bool erase(int index)
+    {
+        if (!contains(index))
+        {
+            return false;
+        }
+
+        m_bits[index >> 6] &= ~(std::uint64_t{1} << (index & 63));
+
+        const int slot = m_slot[index];
+        const int last = m_members.back();
+        m_members[slot] = last;
+        m_slot[last] = slot;
+        m_members.pop_back();
+        m_slot[index] = -1;
+        return true;
+    }
+
+private:
+    std::vector<std::uint64_t> m_bits;
+    std::vector<int> m_members;
+    std::vector<int> m_slot; // each member's position in m_members
+};
+
+#endif // CELLSET_H
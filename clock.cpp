@@ -21,40 +21,90 @@
 
 namespace {
 
-constexpr auto kInterval = std::chrono::seconds{1};
+constexpr qint64 kNsPerSecond = std::chrono::nanoseconds{std::chrono::seconds{1}}.count();
+constexpr qint64 kNsPerMs = std::chrono::nanoseconds{std::chrono::milliseconds{1}}.count();
 
 }
 
 Clock::Clock(QObject *parent)
     : QObject{parent}
-    , m_timer(new QTimer(this))
-    , m_elapsed(0)
-    , m_active(false)
+    , m_bankedNs(0)
+    , m_ticker(new QTimer(this))
+    , m_ticked(0)
+    , m_displayed(true)
 {
-    m_timer->setInterval(kInterval);
-    connect(m_timer, &QTimer::timeout, this, &Clock::onTick);
+    // Each tick is scheduled for the next whole second rather than repeated
+    // every second, so the ticks never drift from the time kept.
+    m_ticker->setSingleShot(true);
+    m_ticker->setTimerType(Qt::PreciseTimer);
+    connect(m_ticker, &QTimer::timeout, this, &Clock::onTick);
+}
+
+qint64 Clock::elapsedNs() const
+{
+    return m_bankedNs + (m_running.isValid() ? m_running.nsecsElapsed() : 0);
+}
+
+double Clock::elapsedSeconds() const
+{
+    return static_cast<double>(elapsedNs()) / kNsPerSecond;
 }
 
 int Clock::getElapsed() const
 {
-    return m_elapsed;
+    return static_cast<int>(elapsedNs() / kNsPerSecond);
+}
+
+void Clock::restore(qint64 elapsedNs)
+{
+    m_bankedNs = elapsedNs;
+    if (m_running.isValid())
+    {
+        m_running.restart();
+    }
+    if (m_displayed)
+    {
+        m_ticked = getElapsed();
+        emit tick(m_ticked);
+    }
+    else
+    {
+        // Tick as soon as the clock is displayed again.
+        m_ticked = -1;
+    }
+    scheduleTick();
+}
+
+void Clock::setDisplayed(bool displayed)
+{
+    m_displayed = displayed;
+    if (m_displayed)
+    {
+        // Catch up on whatever seconds passed out of sight.
+        onTick();
+    }
+    else
+    {
+        m_ticker->stop();
+    }
 }
 
 void Clock::resume()
 {
-    if (!m_active)
+    if (!m_running.isValid())
     {
-        m_active = true;
-        m_timer->start();
+        m_running.start();
+        scheduleTick();
     }
 }
 
 void Clock::pause()
 {
-    if (m_active)
+    if (m_running.isValid())
     {
-        m_active = false;
-        m_timer->stop();
+        m_bankedNs += m_running.nsecsElapsed();
+        m_running.invalidate();
+        m_ticker->stop();
 
         emit paused();
     }
@@ -62,19 +112,34 @@ void Clock::pause()
 
 void Clock::reset()
 {
-    if (m_active)
-    {
-        m_active = false;
-        m_timer->stop();
-    }
+    m_running.invalidate();
+    m_ticker->stop();
 
-    m_elapsed = 0;
+    m_bankedNs = 0;
+    m_ticked = 0;
 
     emit didReset();
 }
 
 void Clock::onTick()
 {
-    m_elapsed++;
-    emit tick(m_elapsed);
+    const int elapsed = getElapsed();
+    if (elapsed != m_ticked)
+    {
+        m_ticked = elapsed;
+        emit tick(m_ticked);
+    }
+    scheduleTick();
+}
+
+void Clock::scheduleTick()
+{
+    if (!m_running.isValid() || !m_displayed)
+    {
+        m_ticker->stop();
+        return;
+    }
+
+    const qint64 untilNextNs = kNsPerSecond - elapsedNs() % kNsPerSecond;
+    m_ticker->start(static_cast<int>((untilNextNs + kNsPerMs - 1) / kNsPerMs));
 }
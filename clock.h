@@ -18,25 +18,54 @@
 #ifndef CLOCK_H
 #define CLOCK_H
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QTimer>
 
 /**
- * @brief A QTimer with a counter of elapsed seconds.
+ * @brief Keeps the time played in a game, and ticks each whole second for
+ *        a display.
+ *
+ * Time is kept by a monotonic QElapsedTimer, to the nanosecond, so it is
+ * never rounded to the tick.  The ticks come from a separate timer that
+ * only runs while the clock is running and displayed: a paused clock, or
+ * one behind a hidden window, never wakes the process.
  */
 class Clock : public QObject
 {
     Q_OBJECT
 
-    QTimer* m_timer;
-    int m_elapsed;
-    bool m_active;
+    QElapsedTimer m_running; // valid while the clock runs
+    qint64 m_bankedNs;       // time kept before the last resume
+    QTimer* m_ticker;
+    int m_ticked;            // the seconds last passed to tick()
+    bool m_displayed;
 
 public:
     explicit Clock(QObject *parent = nullptr);
 
+    qint64 elapsedNs() const;
+    double elapsedSeconds() const;
+
+    /**
+     * @brief The whole seconds elapsed.
+     */
     int getElapsed() const;
 
+    /**
+     * @brief Sets the time already played, as when resuming a saved game.
+     *        A paused clock stays paused until resume() is called.  The new
+     *        time is ticked at once if the clock is displayed, and otherwise
+     *        once it is.
+     */
+    void restore(qint64 elapsedNs);
+
+    /**
+     * @brief Sets whether anyone can see the ticks.  While not, the clock
+     *        keeps time just the same, but doesn't tick.
+     */
+    void setDisplayed(bool displayed);
+
 signals:
     void tick(int elapsed);
     void paused();
@@ -49,6 +78,9 @@ public slots:
 
 private slots:
     void onTick();
+
+private:
+    void scheduleTick();
 };
 
 #endif // CLOCK_H
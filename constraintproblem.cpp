@@ -0,0 +1,235 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "constraintproblem.h"
+
+#include "zobrist.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+int findRoot(std::vector<int>& parents, int n)
+{
+    while (parents[n] != n)
+    {
+        parents[n] = parents[parents[n]];
+        n = parents[n];
+    }
+    return n;
+}
+
+} // namespace
+
+std::uint64_t ConstraintProblem::Component::key() const
+{
+    // Each constraint's own keys are mixed before being combined, so that the
+    // hash tells which cells go with which count.  Like any hash it can
+    // collide, so a cache must still compare the components themselves.
+    std::uint64_t key = 0;
+    for (int ix : cells)
+    {
+        key ^= Zobrist::key(ix, Zobrist::Unknown);
+    }
+
+    for (const Constraint& constraint : constraints)
+    {
+        std::uint64_t constraintKey = Zobrist::key(constraint.mines, Zobrist::ConstraintMines);
+        for (int position : constraint.cells)
+        {
+            constraintKey ^= Zobrist::key(cells[position], Zobrist::Constrained);
+        }
+        key ^= Zobrist::mix(constraintKey);
+    }
+    return key;
+}
+
+ConstraintProblem ConstraintProblem::fromState(const GameState& state, const Solver* solver)
+{
+    ConstraintProblem problem;
+    problem.positionKey = state.knowledgeHash() ^ (solver != nullptr ? Zobrist::key(0, Zobrist::Solved) : 0);
+
+    auto isUnknown = [&](int ix) {
+        return !state.isRevealed(ix)
+               && (solver == nullptr || solver->knowledge(ix) == Solver::Knowledge::Unknown);
+    };
+
+    // Only cells on the frontier are covered by any constraint, and a solver
+    // can only prove cells from the numbers beside them, so the frontier and
+    // its numbers are all that is visited.  Past that, the board is swept once
+    // for the interior and any revealed mines.  The frontier is sorted so that
+    // the problem is the same however its cells were revealed.
+    const CellSet& onFrontier = state.frontier();
+    std::vector<int> frontier(onFrontier.begin(), onFrontier.end());
+    std::sort(frontier.begin(), frontier.end());
+
+    auto positionOnFrontier = [&frontier](int ix) {
+        return static_cast<int>(std::lower_bound(frontier.begin(), frontier.end(), ix) - frontier.begin());
+    };
+
+    int minesAccountedFor = 0;
+
+    const std::vector<GameState::CellBits>& cells = state.cells();
+    for (int ix = 0; ix < state.size(); ++ix)
+    {
+        if (cells[ix] & GameState::kRevealedBit)
+        {
+            minesAccountedFor += (cells[ix] & GameState::kMineBit) ? 1 : 0;
+        }
+        else if (!onFrontier.contains(ix))
+        {
+            problem.interior.push_back(ix);
+        }
+    }
+
+    for (int ix : frontier)
+    {
+        if (solver != nullptr && solver->knowledge(ix) == Solver::Knowledge::Mine)
+        {
+            problem.knownMines.push_back(ix);
+            ++minesAccountedFor;
+        }
+        else if (solver != nullptr && solver->knowledge(ix) == Solver::Knowledge::Safe)
+        {
+            problem.knownSafe.push_back(ix);
+        }
+    }
+
+    problem.minesLeft = state.mineCount() - minesAccountedFor;
+
+    // Every revealed number with unknown neighbors is a constraint over them,
+    // and every such number borders the frontier.
+    std::vector<int> numbers;
+    for (int ix : frontier)
+    {
+        state.forEachNeighbor(ix, [&](int n) {
+            if (state.isRevealed(n) && !state.isMine(n))
+            {
+                numbers.push_back(n);
+            }
+        });
+    }
+    std::sort(numbers.begin(), numbers.end());
+    numbers.erase(std::unique(numbers.begin(), numbers.end()), numbers.end());
+
+    struct FrontierConstraint
+    {
+        std::vector<int> cells; // positions on the frontier
+        int mines;
+    };
+
+    std::vector<FrontierConstraint> constraints;
+    std::vector<int> parents(frontier.size());
+    std::iota(parents.begin(), parents.end(), 0);
+
+    for (int ix : numbers)
+    {
+        FrontierConstraint constraint{{}, state.neighboringMines(ix)};
+        state.forEachNeighbor(ix, [&](int n) {
+            if (isUnknown(n))
+            {
+                constraint.cells.push_back(positionOnFrontier(n));
+            }
+            else if (state.isRevealed(n) ? state.isMine(n) : solver->knowledge(n) == Solver::Knowledge::Mine)
+            {
+                // A revealed mine, or one the solver has proven.
+                --constraint.mines;
+            }
+        });
+
+        if (constraint.cells.empty())
+        {
+            continue;
+        }
+
+        for (int n : constraint.cells)
+        {
+            parents[findRoot(parents, n)] = findRoot(parents, constraint.cells.front());
+        }
+
+        constraints.push_back(std::move(constraint));
+    }
+
+    // Group frontier cells by component, ordering each component breadth-first
+    // through its constraints.
+    std::vector<std::vector<int>> constraintsOf(frontier.size());
+    for (int c = 0; c < static_cast<int>(constraints.size()); ++c)
+    {
+        for (int n : constraints[c].cells)
+        {
+            constraintsOf[n].push_back(c);
+        }
+    }
+
+    std::vector<int> componentOf(frontier.size(), -1);
+    std::vector<int> position(frontier.size(), -1);
+
+    for (int f = 0; f < static_cast<int>(frontier.size()); ++f)
+    {
+        if (!isUnknown(frontier[f]) || componentOf[findRoot(parents, f)] >= 0)
+        {
+            continue;
+        }
+
+        const int id = static_cast<int>(problem.components.size());
+        componentOf[findRoot(parents, f)] = id;
+
+        std::vector<int> members{f};
+        position[f] = 0;
+
+        for (size_t next = 0; next < members.size(); ++next)
+        {
+            for (int c : constraintsOf[members[next]])
+            {
+                for (int n : constraints[c].cells)
+                {
+                    if (position[n] < 0)
+                    {
+                        position[n] = static_cast<int>(members.size());
+                        members.push_back(n);
+                    }
+                }
+            }
+        }
+
+        Component component;
+        component.cells.reserve(members.size());
+        for (int n : members)
+        {
+            component.cells.push_back(frontier[n]);
+        }
+
+        problem.components.push_back(std::move(component));
+    }
+
+    for (FrontierConstraint& constraint : constraints)
+    {
+        Component& component = problem.components[componentOf[findRoot(parents, constraint.cells.front())]];
+
+        Constraint local{{}, constraint.mines};
+        local.cells.reserve(constraint.cells.size());
+        for (int n : constraint.cells)
+        {
+            local.cells.push_back(position[n]);
+        }
+
+        component.constraints.push_back(std::move(local));
+    }
+
+    return problem;
+}
@@ -0,0 +1,97 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef CONSTRAINTPROBLEM_H
+#define CONSTRAINTPROBLEM_H
+
+#include "gamestate.h"
+#include "solver.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief What the player knows about the unrevealed cells, as a set of
+ *        linear constraints, split into independent components.
+ *
+ * Unrevealed cells fall into three groups:
+ *
+ *   - known: cells a Solver has already proven safe or mined;
+ *   - frontier: unknown cells next to at least one revealed number;
+ *   - interior: unknown cells next to no revealed number, about which only
+ *     the total number of mines left says anything.
+ *
+ * Frontier cells are grouped into components such that no constraint spans
+ * two of them, so each component can be reasoned about on its own.
+ */
+struct ConstraintProblem
+{
+    struct Constraint
+    {
+        std::vector<int> cells; // positions within the component's cells
+        int mines;              // mines among those cells
+
+        bool operator==(const Constraint&) const = default;
+    };
+
+    struct Component
+    {
+        // Global cell indices, ordered so that each constraint's cells are
+        // close together, which keeps enumeration over them narrow.
+        std::vector<int> cells;
+        std::vector<Constraint> constraints;
+
+        bool operator==(const Component&) const = default;
+
+        /**
+         * @brief A hash of the component's cells and constraints, built from
+         *        Zobrist keys, for caching whatever is worked out about it.
+         */
+        std::uint64_t key() const;
+    };
+
+    std::vector<Component> components;
+    std::vector<int> interior;
+    std::vector<int> knownMines;
+    std::vector<int> knownSafe;
+
+    /**
+     * @brief Mines not yet accounted for by knownMines, to be shared between
+     *        the frontier and the interior.
+     */
+    int minesLeft{};
+
+    /**
+     * @brief The position the problem was gathered from: the state's
+     *        knowledgeHash(), marked if a solver's deductions were applied.
+     *        Nothing for a problem put together by hand.
+     */
+    std::optional<std::uint64_t> positionKey;
+
+    /**
+     * @brief Gathers the constraints visible in the given state.  If a solver
+     *        is given, the cells it has proven are taken as known.
+     *
+     * Works from GameState::frontier(): only frontier cells and the numbers
+     * beside them are visited one by one, and the rest of the board is read
+     * in a single pass for the interior.
+     */
+    static ConstraintProblem fromState(const GameState& state, const Solver* solver = nullptr);
+};
+
+#endif // CONSTRAINTPROBLEM_H
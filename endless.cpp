@@ -0,0 +1,552 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "endless.h"
+
+#include "neighborcount.h"
+#include "zobrist.h"
+
+#include <algorithm>
+#include <array>
+
+namespace {
+
+constexpr int kPadded = EndlessWorld::kChunkSize + 2;
+
+int chunkOf(int coordinate)
+{
+    // An arithmetic shift rounds toward negative infinity, as chunks need.
+    return coordinate >> EndlessWorld::kChunkShift;
+}
+
+int indexInChunk(QPoint cell)
+{
+    constexpr int kMask = EndlessWorld::kChunkSize - 1;
+    return (cell.y() & kMask) * EndlessWorld::kChunkSize + (cell.x() & kMask);
+}
+
+// The chunk coordinates that a key was made from.
+QPoint chunkAt(std::uint64_t key)
+{
+    return QPoint{static_cast<int>(static_cast<std::uint32_t>(key)), static_cast<int>(static_cast<std::uint32_t>(key >> 32))};
+}
+
+bool testBit(const std::vector<std::uint64_t>& bits, int index)
+{
+    return !bits.empty() && ((bits[index >> 6] >> (index & 63)) & 1);
+}
+
+void setBit(std::vector<std::uint64_t>& bits, int index)
+{
+    bits[index >> 6] |= std::uint64_t{1} << (index & 63);
+}
+
+// Reveals a cell of a freshly generated chunk in the given bitset, along
+// with as much of its opening as lies within the chunk.  Every revealed cell
+// lies in some opening, and every revealed zero brings all its neighbors, so
+// replaying this from enough of a chunk's revealed cells restores them all.
+void revealWithin(const std::vector<GameState::CellBits>& cells, int index, std::vector<std::uint64_t>& revealed)
+{
+    constexpr int kSize = EndlessWorld::kChunkSize;
+
+    std::vector<int> pending;
+    auto reveal = [&](int i) {
+        if (!testBit(revealed, i))
+        {
+            setBit(revealed, i);
+            if (cells[i] == 0)
+            {
+                pending.push_back(i);
+            }
+        }
+    };
+
+    reveal(index);
+    while (!pending.empty())
+    {
+        const int zero = pending.back();
+        pending.pop_back();
+
+        const int x = zero % kSize;
+        const int y = zero / kSize;
+        for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, kSize - 1); ++ny)
+        {
+            for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, kSize - 1); ++nx)
+            {
+                reveal(ny * kSize + nx);
+            }
+        }
+    }
+}
+
+} // namespace
+
+EndlessWorld::EndlessWorld(std::uint64_t seed, double density, qsizetype maxBytes)
+    : m_seed{seed}
+    , m_density{std::clamp(density, kMinDensity, kMaxDensity)}
+    , m_threshold{static_cast<std::uint64_t>(m_density * 18446744073709551616.0)}
+    , m_maxBytes{std::max(maxBytes, qsizetype{0})}
+    , m_liveChunks{0}
+    , m_bytes{0}
+    , m_tick{0}
+    , m_cleared{0}
+{
+}
+
+std::uint64_t EndlessWorld::chunkKey(int chunkX, int chunkY)
+{
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(chunkY)) << 32) | static_cast<std::uint32_t>(chunkX);
+}
+
+qsizetype EndlessWorld::bytesOf(const Chunk& chunk)
+{
+    // The map node, with its key, link and bucket, and whatever the vectors hold.
+    const size_t bytes = sizeof(Chunk) + sizeof(std::uint64_t) + 3 * sizeof(void*)
+                         + chunk.cells.capacity() * sizeof(GameState::CellBits)
+                         + (chunk.revealed.capacity() + chunk.flagged.capacity()) * sizeof(std::uint64_t)
+                         + (chunk.replays.capacity() + chunk.flags.capacity()) * sizeof(quint16);
+    return static_cast<qsizetype>(bytes);
+}
+
+bool EndlessWorld::mineAt(int x, int y) const
+{
+    if (x >= -1 && x <= 1 && y >= -1 && y <= 1)
+    {
+        return false;
+    }
+
+    // The chunk's own stream is keyed by the seed and its coordinates, and
+    // each cell is a counter into it.
+    const std::uint64_t stream = Zobrist::mix(m_seed ^ Zobrist::mix(chunkKey(chunkOf(x), chunkOf(y))));
+    const std::uint64_t counter = static_cast<std::uint64_t>(indexInChunk(QPoint{x, y}));
+    return Zobrist::mix(stream + counter * 0x9e3779b97f4a7c15ULL) < m_threshold;
+}
+
+int EndlessWorld::countAt(int x, int y) const
+{
+    int count = 0;
+    for (int dy = -1; dy <= 1; ++dy)
+    {
+        for (int dx = -1; dx <= 1; ++dx)
+        {
+            if ((dx != 0 || dy != 0) && mineAt(x + dx, y + dy))
+            {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+bool EndlessWorld::isMine(QPoint cell) const
+{
+    return mineAt(cell.x(), cell.y());
+}
+
+int EndlessWorld::neighboringMines(QPoint cell) const
+{
+    return cellAt(cell) & GameState::kCountMask;
+}
+
+GameState::CellBits EndlessWorld::cellAt(QPoint cell) const
+{
+    const auto found = m_chunks.find(chunkKey(chunkOf(cell.x()), chunkOf(cell.y())));
+    const int index = indexInChunk(cell);
+
+    if (found != m_chunks.end() && !found->second.cells.empty())
+    {
+        return found->second.cells[index];
+    }
+
+    // Untouched, compressed or evicted: work out what's needed from the seed,
+    // and only count the neighbors of cells that are showing their number.
+    GameState::CellBits bits = mineAt(cell.x(), cell.y()) ? GameState::kMineBit : 0;
+    if (found != m_chunks.end())
+    {
+        const Chunk& chunk = found->second;
+
+        bool revealed = testBit(chunk.revealed, index);
+        if (!chunk.replays.empty())
+        {
+            // Evicted chunks are out of view, so are rarely asked about.
+            Chunk scratch;
+            generate(scratch, chunkOf(cell.x()), chunkOf(cell.y()));
+
+            std::vector<std::uint64_t> replayed(kChunkCells / 64, 0);
+            for (int replay : chunk.replays)
+            {
+                revealWithin(scratch.cells, replay, replayed);
+            }
+            revealed = testBit(replayed, index);
+        }
+
+        if (revealed)
+        {
+            bits |= GameState::kRevealedBit | static_cast<GameState::CellBits>(countAt(cell.x(), cell.y()));
+        }
+        if (testBit(chunk.flagged, index) || std::binary_search(chunk.flags.begin(), chunk.flags.end(), index))
+        {
+            bits |= GameState::kFlaggedBit;
+        }
+    }
+    return bits;
+}
+
+void EndlessWorld::generate(Chunk& chunk, int chunkX, int chunkY) const
+{
+    // Lay the chunk's mines with a one-cell margin from its neighbors, so
+    // that the usual kernel counts its edge cells correctly.
+    std::array<std::uint8_t, kPadded * kPadded> mines;
+    std::array<std::uint8_t, kPadded * kPadded> counts;
+
+    const int left = chunkX * kChunkSize - 1;
+    const int top = chunkY * kChunkSize - 1;
+    for (int y = 0; y < kPadded; ++y)
+    {
+        for (int x = 0; x < kPadded; ++x)
+        {
+            mines[y * kPadded + x] = mineAt(left + x, top + y) ? 1 : 0;
+        }
+    }
+
+    ::countNeighboringMines(mines.data(), counts.data(), kPadded, kPadded);
+
+    chunk.cells.resize(kChunkCells);
+    for (int y = 0; y < kChunkSize; ++y)
+    {
+        for (int x = 0; x < kChunkSize; ++x)
+        {
+            const int padded = (y + 1) * kPadded + (x + 1);
+            chunk.cells[y * kChunkSize + x] = static_cast<GameState::CellBits>(
+                counts[padded] | (mines[padded] ? GameState::kMineBit : 0));
+        }
+    }
+}
+
+EndlessWorld::Chunk& EndlessWorld::touch(QPoint cell, int& index)
+{
+    const int chunkX = chunkOf(cell.x());
+    const int chunkY = chunkOf(cell.y());
+    const auto [found, inserted] = m_chunks.try_emplace(chunkKey(chunkX, chunkY));
+    Chunk& chunk = found->second;
+    if (inserted)
+    {
+        m_bytes += bytesOf(chunk);
+    }
+
+    if (chunk.cells.empty())
+    {
+        m_bytes -= bytesOf(chunk);
+        generate(chunk, chunkX, chunkY);
+
+        // An evicted chunk goes back to bitsets first, by replaying its reveals.
+        if (chunk.revealed.empty())
+        {
+            if (!chunk.replays.empty())
+            {
+                chunk.revealed.assign(kChunkCells / 64, 0);
+                for (int replay : chunk.replays)
+                {
+                    revealWithin(chunk.cells, replay, chunk.revealed);
+                }
+            }
+            if (!chunk.flags.empty())
+            {
+                chunk.flagged.assign(kChunkCells / 64, 0);
+                for (int flag : chunk.flags)
+                {
+                    setBit(chunk.flagged, flag);
+                }
+            }
+            std::vector<quint16>().swap(chunk.replays);
+            std::vector<quint16>().swap(chunk.flags);
+        }
+
+        // Restore what was compressed, if anything was.
+        for (int i = 0; i < kChunkCells; ++i)
+        {
+            if (testBit(chunk.revealed, i))
+            {
+                chunk.cells[i] |= GameState::kRevealedBit;
+            }
+            if (testBit(chunk.flagged, i))
+            {
+                chunk.cells[i] |= GameState::kFlaggedBit;
+            }
+        }
+        std::vector<std::uint64_t>().swap(chunk.revealed);
+        std::vector<std::uint64_t>().swap(chunk.flagged);
+
+        m_bytes += bytesOf(chunk);
+        chunk.evictable = true;
+        ++m_liveChunks;
+    }
+
+    chunk.lastUsed = ++m_tick;
+    index = indexInChunk(cell);
+    return chunk;
+}
+
+void EndlessWorld::compress(Chunk& chunk)
+{
+    m_bytes -= bytesOf(chunk);
+    chunk.revealed.assign(kChunkCells / 64, 0);
+
+    bool anyFlagged = false;
+    for (int i = 0; i < kChunkCells; ++i)
+    {
+        if (chunk.cells[i] & GameState::kRevealedBit)
+        {
+            chunk.revealed[i >> 6] |= std::uint64_t{1} << (i & 63);
+        }
+        anyFlagged |= (chunk.cells[i] & GameState::kFlaggedBit) != 0;
+    }
+
+    if (anyFlagged)
+    {
+        chunk.flagged.assign(kChunkCells / 64, 0);
+        for (int i = 0; i < kChunkCells; ++i)
+        {
+            if (chunk.cells[i] & GameState::kFlaggedBit)
+            {
+                chunk.flagged[i >> 6] |= std::uint64_t{1} << (i & 63);
+            }
+        }
+    }
+
+    std::vector<GameState::CellBits>().swap(chunk.cells);
+    m_bytes += bytesOf(chunk);
+    --m_liveChunks;
+}
+
+void EndlessWorld::evict(std::uint64_t key)
+{
+    const auto found = m_chunks.find(key);
+    Chunk& chunk = found->second;
+
+    Chunk fresh;
+    generate(fresh, chunkAt(key).x(), chunkAt(key).y());
+
+    // Zeros first, as each brings back its whole opening within the chunk;
+    // then whatever they leave, such as numbers revealed one at a time, or
+    // by openings that began in another chunk.
+    std::vector<quint16> replays;
+    std::vector<std::uint64_t> covered(kChunkCells / 64, 0);
+    for (const bool zeros : {true, false})
+    {
+        for (int i = 0; i < kChunkCells; ++i)
+        {
+            if ((fresh.cells[i] == 0) == zeros && testBit(chunk.revealed, i) && !testBit(covered, i))
+            {
+                replays.push_back(static_cast<quint16>(i));
+                revealWithin(fresh.cells, i, covered);
+            }
+        }
+    }
+
+    std::vector<quint16> flags;
+    for (int i = 0; i < kChunkCells; ++i)
+    {
+        if (testBit(chunk.flagged, i))
+        {
+            flags.push_back(static_cast<quint16>(i));
+        }
+    }
+
+    // A chunk played all over may take more cells to replay than its bitsets.
+    // It can't change until it's live again, so it needn't be tried again.
+    const size_t listed = (replays.size() + flags.size()) * sizeof(quint16);
+    if (listed >= (chunk.revealed.size() + chunk.flagged.size()) * sizeof(std::uint64_t))
+    {
+        chunk.evictable = false;
+        return;
+    }
+
+    m_bytes -= bytesOf(chunk);
+    if (replays.empty() && flags.empty())
+    {
+        // Nothing was revealed or left flagged, so there's nothing to keep.
+        m_chunks.erase(found);
+        return;
+    }
+
+    replays.shrink_to_fit();
+    flags.shrink_to_fit();
+    chunk.replays = std::move(replays);
+    chunk.flags = std::move(flags);
+    std::vector<std::uint64_t>().swap(chunk.revealed);
+    std::vector<std::uint64_t>().swap(chunk.flagged);
+    m_bytes += bytesOf(chunk);
+}
+
+bool EndlessWorld::inViewport(std::uint64_t key) const
+{
+    if (m_viewport.isEmpty())
+    {
+        return false;
+    }
+
+    const QPoint chunk = chunkAt(key);
+    return chunk.x() >= chunkOf(m_viewport.left()) && chunk.x() <= chunkOf(m_viewport.right())
+           && chunk.y() >= chunkOf(m_viewport.top()) && chunk.y() <= chunkOf(m_viewport.bottom());
+}
+
+void EndlessWorld::trim()
+{
+    if (m_bytes <= m_maxBytes)
+    {
+        return;
+    }
+
+    // The keys of the chunks wanted, least recently used first.
+    auto oldest = [this](auto&& wanted) {
+        std::vector<std::pair<qint64, std::uint64_t>> keys;
+        for (const auto& [key, chunk] : m_chunks)
+        {
+            if (wanted(key, chunk))
+            {
+                keys.emplace_back(chunk.lastUsed, key);
+            }
+        }
+        std::sort(keys.begin(), keys.end());
+        return keys;
+    };
+
+    const auto live = oldest([this](std::uint64_t key, const Chunk& chunk) {
+        return !chunk.cells.empty() && !inViewport(key);
+    });
+    for (const auto& [lastUsed, key] : live)
+    {
+        if (m_bytes <= m_maxBytes)
+        {
+            return;
+        }
+        compress(m_chunks.at(key));
+    }
+
+    // Stored chunks in view are always live, so none of these are in view.
+    const auto compressed = oldest([](std::uint64_t, const Chunk& chunk) {
+        return !chunk.revealed.empty() && chunk.evictable;
+    });
+    for (const auto& [lastUsed, key] : compressed)
+    {
+        if (m_bytes <= m_maxBytes)
+        {
+            return;
+        }
+        evict(key);
+    }
+}
+
+void EndlessWorld::setViewport(const QRect& cells)
+{
+    m_viewport = cells;
+
+    // Only chunks already stored are made live; the rest have nothing to show
+    // but raised cells, which needs no generation.
+    for (int chunkY = chunkOf(cells.top()); chunkY <= chunkOf(cells.bottom()); ++chunkY)
+    {
+        for (int chunkX = chunkOf(cells.left()); chunkX <= chunkOf(cells.right()); ++chunkX)
+        {
+            if (m_chunks.count(chunkKey(chunkX, chunkY)) != 0)
+            {
+                int index = 0;
+                touch(QPoint{chunkX * kChunkSize, chunkY * kChunkSize}, index);
+            }
+        }
+    }
+
+    trim();
+}
+
+bool EndlessWorld::revealCell(QPoint cell)
+{
+    int index = 0;
+    GameState::CellBits& bits = touch(cell, index).cells[index];
+    if (bits & GameState::kRevealedBit)
+    {
+        return false;
+    }
+
+    bits = (bits | GameState::kRevealedBit) & ~GameState::kFlaggedBit;
+    if (!(bits & GameState::kMineBit))
+    {
+        ++m_cleared;
+    }
+    return true;
+}
+
+std::vector<QPoint> EndlessWorld::revealArea(QPoint cell)
+{
+    std::vector<QPoint> revealed;
+    if (!revealCell(cell))
+    {
+        return revealed;
+    }
+
+    revealed.push_back(cell);
+
+    std::vector<QPoint> pending;
+    if (cellAt(cell) == GameState::kRevealedBit)
+    {
+        pending.push_back(cell);
+    }
+
+    // A depth-first fill; the opening may cross any number of chunks, but is
+    // always finite at the densities allowed.
+    while (!pending.empty())
+    {
+        const QPoint zero = pending.back();
+        pending.pop_back();
+
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                const QPoint neighbor{zero.x() + dx, zero.y() + dy};
+                if ((dx == 0 && dy == 0) || !revealCell(neighbor))
+                {
+                    continue;
+                }
+
+                revealed.push_back(neighbor);
+                if (cellAt(neighbor) == GameState::kRevealedBit)
+                {
+                    pending.push_back(neighbor);
+                }
+            }
+        }
+    }
+
+    trim();
+    return revealed;
+}
+
+bool EndlessWorld::toggleFlag(QPoint cell)
+{
+    int index = 0;
+    Chunk& chunk = touch(cell, index);
+    GameState::CellBits& bits = chunk.cells[index];
+    if (bits & GameState::kRevealedBit)
+    {
+        return false;
+    }
+
+    bits ^= GameState::kFlaggedBit;
+    trim();
+    return true;
+}
@@ -0,0 +1,154 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ENDLESS_H
+#define ENDLESS_H
+
+#include "gamestate.h"
+
+#include <QPoint>
+#include <QRect>
+#include <QtGlobal>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief An unbounded board, generated lazily in square chunks.
+ *
+ * Whether a cell holds a mine is a pure function of the world's seed, the
+ * chunk's coordinates and the cell's position within it, computed with a
+ * counter-based hash rather than drawn from a sequential generator.  Any
+ * cell can therefore be examined without generating anything else, and
+ * chunks nobody has touched cost no memory at all: only chunks in which a
+ * cell has been revealed or flagged are stored.
+ *
+ * A stored chunk is either live, with one byte per cell in GameState's
+ * layout, or compressed to bitsets of its revealed and flagged cells, from
+ * which, with the seed, the live form is rebuilt.  A compressed chunk can
+ * be evicted further, to the few cells whose reveals, replayed within the
+ * chunk, reveal the same cells again, and a list of its flags.  Every
+ * stored chunk is charged for its memory.  Whenever the charges pass the
+ * budget, the chunks outside the viewport that were used least recently
+ * are compressed, and then the compressed chunks used least recently are
+ * evicted, where that makes them smaller.
+ *
+ * The cells around the origin never hold mines, so revealing it always
+ * opens an area to start from.  The density is kept high enough that zero
+ * cells can't percolate, so every opening is finite.
+ */
+class EndlessWorld
+{
+public:
+    static constexpr int kChunkShift = 6;
+    static constexpr int kChunkSize = 1 << kChunkShift;
+    static constexpr int kChunkCells = kChunkSize * kChunkSize;
+
+    static constexpr double kMinDensity = 0.12;
+    static constexpr double kMaxDensity = 0.5;
+
+    /**
+     * @param density the probability that any one cell holds a mine, clamped
+     *        to [kMinDensity, kMaxDensity].
+     * @param maxBytes roughly the most memory that stored chunks may hold,
+     *        though chunks in the viewport stay live whatever they cost.
+     */
+    explicit EndlessWorld(std::uint64_t seed, double density = 0.18, qsizetype maxBytes = qsizetype{1} << 20);
+
+    std::uint64_t seed() const { return m_seed; }
+    double density() const { return m_density; }
+
+    bool isMine(QPoint cell) const;
+    bool isRevealed(QPoint cell) const { return (cellAt(cell) & GameState::kRevealedBit) != 0; }
+    bool isFlagged(QPoint cell) const { return (cellAt(cell) & GameState::kFlaggedBit) != 0; }
+    int neighboringMines(QPoint cell) const;
+
+    /**
+     * @brief Reveals a cell and, if it has no neighboring mines, the whole
+     *        opening around it, across as many chunks as it spans.
+     * @return every cell that this call revealed, the given cell first.
+     */
+    std::vector<QPoint> revealArea(QPoint cell);
+
+    /**
+     * @brief Flags or unflags an unrevealed cell.
+     * @return true if the flag changed.
+     */
+    bool toggleFlag(QPoint cell);
+
+    /**
+     * @brief Sets the cells on screen.  Stored chunks that overlap them are
+     *        made live, and are never compressed while they remain in view.
+     */
+    void setViewport(const QRect& cells);
+
+    /**
+     * @brief Safe cells revealed so far: the player's score.
+     */
+    qint64 cleared() const { return m_cleared; }
+
+    int liveChunks() const { return m_liveChunks; }
+    int storedChunks() const { return static_cast<int>(m_chunks.size()); }
+
+    /**
+     * @brief The memory that stored chunks are charged for.
+     */
+    qsizetype storedBytes() const { return m_bytes; }
+
+private:
+    struct Chunk
+    {
+        std::vector<GameState::CellBits> cells; // kChunkCells bytes while live; empty otherwise
+        std::vector<std::uint64_t> revealed;    // kChunkCells bits while compressed; empty otherwise
+        std::vector<std::uint64_t> flagged;     // likewise, or empty if nothing is flagged
+        std::vector<quint16> replays;           // while evicted, the cells to reveal again
+        std::vector<quint16> flags;             // while evicted, the flagged cells
+        qint64 lastUsed{};
+        bool evictable{true};                   // false once eviction is found not to shrink it
+    };
+
+    static std::uint64_t chunkKey(int chunkX, int chunkY);
+    static qsizetype bytesOf(const Chunk& chunk);
+
+    GameState::CellBits cellAt(QPoint cell) const;
+    bool mineAt(int x, int y) const;
+    int countAt(int x, int y) const;
+
+    Chunk& touch(QPoint cell, int& index);
+    void generate(Chunk& chunk, int chunkX, int chunkY) const;
+    void compress(Chunk& chunk);
+    void evict(std::uint64_t key);
+    bool inViewport(std::uint64_t key) const;
+    void trim();
+
+    bool revealCell(QPoint cell);
+
+    std::uint64_t m_seed;
+    double m_density;
+    std::uint64_t m_threshold; // a cell is a mine if its hash is below this
+    qsizetype m_maxBytes;
+
+    std::unordered_map<std::uint64_t, Chunk> m_chunks;
+    int m_liveChunks;
+    qsizetype m_bytes; // what every stored chunk is charged, in all
+    qint64 m_tick; // advanced on every touch, to find the least recently used chunks
+    QRect m_viewport;
+    qint64 m_cleared;
+};
+
+#endif // ENDLESS_H
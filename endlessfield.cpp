@@ -0,0 +1,271 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "endlessfield.h"
+
+#include <QPainter>
+#include <QSizePolicy>
+
+#include <utility>
+
+namespace {
+
+constexpr int kCellSize = 30;
+
+// How far one press of an arrow key, or one notch of the wheel, scrolls.
+constexpr int kKeyScrollCells = 8;
+constexpr int kWheelScrollCells = 3;
+
+} // namespace
+
+EndlessField::EndlessField(std::uint64_t seed, QWidget *parent)
+    : QWidget{parent}
+    , m_world{seed}
+    , m_origin{-kViewCols / 2, -kViewRows / 2}
+    , m_started{}
+    , m_gameOver{}
+{
+    setFixedSize(sizeHint());
+    setFocusPolicy(Qt::StrongFocus);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+
+    m_world.setViewport(visibleCells());
+}
+
+QSize EndlessField::sizeHint() const
+{
+    return QSize{kViewCols * kCellSize, kViewRows * kCellSize};
+}
+
+QPoint EndlessField::cellAt(const QPoint& pos) const
+{
+    return QPoint{m_origin.x() + pos.x() / kCellSize, m_origin.y() + pos.y() / kCellSize};
+}
+
+QRect EndlessField::cellRect(const QPoint& cell) const
+{
+    return QRect{(cell.x() - m_origin.x()) * kCellSize, (cell.y() - m_origin.y()) * kCellSize, kCellSize, kCellSize};
+}
+
+QRect EndlessField::visibleCells() const
+{
+    return QRect{m_origin.x(), m_origin.y(), (width() + kCellSize - 1) / kCellSize, (height() + kCellSize - 1) / kCellSize};
+}
+
+void EndlessField::scrollCells(int dx, int dy)
+{
+    if (dx == 0 && dy == 0)
+    {
+        return;
+    }
+
+    m_origin += QPoint{dx, dy};
+    m_world.setViewport(visibleCells());
+
+    // Moves what's already painted and repaints only what comes into view.
+    scroll(-dx * kCellSize, -dy * kCellSize);
+}
+
+void EndlessField::keyPressEvent(QKeyEvent* event)
+{
+    switch (event->key())
+    {
+    case Qt::Key_Left:
+        scrollCells(-kKeyScrollCells, 0);
+        break;
+    case Qt::Key_Right:
+        scrollCells(kKeyScrollCells, 0);
+        break;
+    case Qt::Key_Up:
+        scrollCells(0, -kKeyScrollCells);
+        break;
+    case Qt::Key_Down:
+        scrollCells(0, kKeyScrollCells);
+        break;
+    default:
+        QWidget::keyPressEvent(event);
+        return;
+    }
+
+    event->accept();
+}
+
+void EndlessField::wheelEvent(QWheelEvent* event)
+{
+    const QPoint notches = event->angleDelta() / 120;
+    if (event->modifiers() & Qt::ShiftModifier)
+    {
+        scrollCells(-(notches.y() + notches.x()) * kWheelScrollCells, 0);
+    }
+    else
+    {
+        scrollCells(-notches.x() * kWheelScrollCells, -notches.y() * kWheelScrollCells);
+    }
+
+    event->accept();
+}
+
+void EndlessField::mousePressEvent(QMouseEvent* event)
+{
+    if (m_gameOver)
+    {
+        event->ignore();
+        return;
+    }
+
+    const QPoint cell = cellAt(event->pos());
+    if (event->button() == Qt::LeftButton)
+    {
+        m_leftPressed = cell;
+        update(cellRect(cell));
+    }
+    else if (event->button() == Qt::RightButton)
+    {
+        m_rightPressed = cell;
+    }
+
+    event->accept();
+}
+
+void EndlessField::mouseReleaseEvent(QMouseEvent* event)
+{
+    // As with a button, a click only counts if it is released over the cell where it began.
+    const QPoint cell = cellAt(event->pos());
+
+    if (event->button() == Qt::LeftButton)
+    {
+        const std::optional<QPoint> pressed = std::exchange(m_leftPressed, std::nullopt);
+        if (pressed)
+        {
+            update(cellRect(*pressed));
+        }
+
+        if (pressed == cell && rect().contains(event->pos()))
+        {
+            reveal(cell);
+        }
+    }
+    else if (event->button() == Qt::RightButton)
+    {
+        const std::optional<QPoint> pressed = std::exchange(m_rightPressed, std::nullopt);
+        if (pressed == cell && rect().contains(event->pos()) && m_world.toggleFlag(cell))
+        {
+            update(cellRect(cell));
+        }
+    }
+
+    event->accept();
+}
+
+void EndlessField::reveal(const QPoint& cell)
+{
+    if (!m_started)
+    {
+        m_started = true;
+        emit gameStarted();
+    }
+
+    const std::vector<QPoint> revealed = m_world.revealArea(cell);
+    if (revealed.empty())
+    {
+        return;
+    }
+
+    // Openings can reach far beyond the view; only what's visible needs
+    // repainting.
+    const QRect visible = visibleCells();
+    QRect dirty;
+    for (const QPoint& ix : revealed)
+    {
+        if (visible.contains(ix))
+        {
+            dirty |= cellRect(ix);
+        }
+    }
+    update(dirty);
+
+    if (m_world.isMine(cell))
+    {
+        m_gameOver = true;
+        update();
+        emit gameLost();
+        return;
+    }
+
+    emit clearedChanged(m_world.cleared());
+}
+
+void EndlessField::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this);
+
+    m_tiles.prepare(QSize{kCellSize, kCellSize}, devicePixelRatioF(), font());
+
+    const QRect exposed = event->rect() & rect();
+    if (exposed.isEmpty())
+    {
+        return;
+    }
+
+    const QPoint topLeft = cellAt(exposed.topLeft());
+    const QPoint bottomRight = cellAt(exposed.bottomRight());
+
+    for (int y = topLeft.y(); y <= bottomRight.y(); ++y)
+    {
+        for (int x = topLeft.x(); x <= bottomRight.x(); ++x)
+        {
+            paintCell(painter, QPoint{x, y});
+        }
+    }
+}
+
+void EndlessField::resizeEvent(QResizeEvent* event)
+{
+    m_world.setViewport(visibleCells());
+
+    QWidget::resizeEvent(event);
+}
+
+void EndlessField::paintCell(QPainter& painter, const QPoint& cell)
+{
+    TileAtlas::Tile tile;
+
+    if (m_world.isRevealed(cell))
+    {
+        tile = m_world.isMine(cell)
+            ? TileAtlas::ExplodedMine
+            : TileAtlas::numberTile(m_world.neighboringMines(cell));
+    }
+    else if (m_gameOver && m_world.isMine(cell))
+    {
+        tile = TileAtlas::Mine;
+    }
+    else if (m_leftPressed == cell)
+    {
+        tile = TileAtlas::Pressed;
+    }
+    else if (m_world.isFlagged(cell))
+    {
+        tile = TileAtlas::Flag;
+    }
+    else
+    {
+        tile = TileAtlas::Raised;
+    }
+
+    painter.drawPixmap(cellRect(cell).topLeft(), m_tiles.tile(tile));
+}
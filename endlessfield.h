@@ -0,0 +1,98 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ENDLESSFIELD_H
+#define ENDLESSFIELD_H
+
+#include "endless.h"
+#include "tileatlas.h"
+
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPoint>
+#include <QRect>
+#include <QResizeEvent>
+#include <QSize>
+#include <QWheelEvent>
+#include <QWidget>
+
+#include <cstdint>
+#include <optional>
+
+/**
+ * @brief A scrolling window onto an EndlessWorld.
+ *
+ * The view scrolls with the arrow keys and the mouse wheel; holding Shift
+ * turns the wheel sideways.  Whatever part of the world is in view is
+ * painted straight from it, so panning over ground nobody has played
+ * generates nothing.  There is no winning, only a score of cells cleared,
+ * until a mine is revealed.
+ */
+class EndlessField : public QWidget
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief The size of the view, in cells, at the standard cell size.
+     */
+    static constexpr int kViewCols = 40;
+    static constexpr int kViewRows = 25;
+
+    explicit EndlessField(std::uint64_t seed, QWidget *parent = nullptr);
+
+    const EndlessWorld& world() const { return m_world; }
+
+    QSize sizeHint() const override;
+
+signals:
+    void gameStarted();
+    void gameLost();
+
+    /**
+     * @brief Emitted after every move that cleared cells, with the new score.
+     */
+    void clearedChanged(qint64 cleared);
+
+protected:
+    void keyPressEvent(QKeyEvent* event) override;
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
+    void wheelEvent(QWheelEvent* event) override;
+
+private:
+    QPoint cellAt(const QPoint& pos) const;
+    QRect cellRect(const QPoint& cell) const;
+    QRect visibleCells() const;
+
+    void scrollCells(int dx, int dy);
+    void reveal(const QPoint& cell);
+    void paintCell(QPainter& painter, const QPoint& cell);
+
+    EndlessWorld m_world;
+    QPoint m_origin; // the world cell at the top-left corner of the view
+    bool m_started;
+    bool m_gameOver;
+    std::optional<QPoint> m_leftPressed;  // the cell where the left button went down
+    std::optional<QPoint> m_rightPressed; // the cell where the right button went down
+    TileAtlas m_tiles;
+};
+
+#endif // ENDLESSFIELD_H
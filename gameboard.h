@@ -59,6 +59,10 @@ public:
 QDataStream& operator<<(QDataStream&, const GameBoard&);
 QDataStream& operator>>(QDataStream&, GameBoard&);
 
+inline constexpr const GameBoard kSmallGame{10, 10, 15};
+inline constexpr const GameBoard kMediumGame{15, 15, 45};
+inline constexpr const GameBoard kLargeGame{16, 30, 99};
+
 Q_DECLARE_METATYPE(GameBoard)
 
 #endif // GAMEBOARD_H
@@ -0,0 +1,549 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "gamestate.h"
+
+#include "neighborcount.h"
+#include "zobrist.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+#include <unordered_set>
+
+GameState::GameState(GameBoard board)
+    : GameState{board, Rng::randomSeed()}
+{
+}
+
+GameState::GameState(GameBoard board, std::uint64_t seed)
+    : m_board{board}
+    , m_seed{seed}
+    , m_cells(static_cast<size_t>(board.rows()) * board.cols(), 0)
+    , m_frontier{board.rows() * board.cols()}
+    , m_knowledgeHash{0}
+    , m_mineCount{0}
+    , m_unrevealedSafeCells{0}
+{
+    Rng rng{seed};
+    placeMines(chooseMines(board, rng));
+    countNeighboringMines();
+    labelOpenings();
+}
+
+GameState::GameState(GameBoard board, const std::vector<int>& mineIndices)
+    : m_board{board}
+    , m_seed{0}
+    , m_cells(static_cast<size_t>(board.rows()) * board.cols(), 0)
+    , m_frontier{board.rows() * board.cols()}
+    , m_knowledgeHash{0}
+    , m_mineCount{0}
+    , m_unrevealedSafeCells{0}
+{
+    placeMines(mineIndices);
+    countNeighboringMines();
+    labelOpenings();
+}
+
+std::vector<int> GameState::chooseMines(const GameBoard& board, Rng& rng)
+{
+    const int rows = board.rows();
+    const int cols = board.cols();
+    const int numCells = rows * cols;
+    if (numCells <= 0)
+    {
+        return {};
+    }
+
+    // Mines may go anywhere but the corners.  Rather than filter the corners
+    // out of a list of every cell, choose among the numbers [0, candidates) and
+    // then step each one past whichever corners precede it.
+    int corners[] = {0, cols - 1, numCells - cols, numCells - 1};
+    std::sort(std::begin(corners), std::end(corners));
+    const auto lastCorner = std::unique(std::begin(corners), std::end(corners));
+
+    const int candidates = numCells - static_cast<int>(lastCorner - std::begin(corners));
+    const int count = std::clamp(board.mines(), 0, std::max(candidates, 0));
+
+    auto toCell = [&](int candidate) {
+        for (auto corner = std::begin(corners); corner != lastCorner; ++corner)
+        {
+            if (candidate >= *corner)
+            {
+                ++candidate;
+            }
+        }
+        return candidate;
+    };
+
+    std::vector<int> mines;
+    mines.reserve(count);
+
+    if (count <= candidates / 2)
+    {
+        // Sparse: Floyd's algorithm draws `count` distinct values with exactly
+        // `count` random numbers, given a set of the values chosen so far.  For
+        // very sparse boards that set is hashed; otherwise a bitmap of the
+        // candidates is both smaller and much faster.
+        auto floyd = [&](auto&& insert) {
+            for (int j = candidates - count; j < candidates; ++j)
+            {
+                int t = static_cast<int>(rng.bounded(static_cast<std::uint32_t>(j + 1)));
+                int pick = insert(t) ? t : j;
+                if (pick == j)
+                {
+                    insert(j);
+                }
+                mines.push_back(toCell(pick));
+            }
+        };
+
+        if (count < candidates / 64)
+        {
+            std::unordered_set<int> chosen;
+            chosen.reserve(count);
+            floyd([&](int n) { return chosen.insert(n).second; });
+        }
+        else
+        {
+            std::vector<bool> chosen(candidates);
+            floyd([&](int n) {
+                if (chosen[n])
+                {
+                    return false;
+                }
+                chosen[n] = true;
+                return true;
+            });
+        }
+    }
+    else
+    {
+        // Dense: a partial Fisher-Yates shuffle, stopping once the first `count`
+        // slots are settled.
+        std::vector<int> slots(candidates);
+        std::iota(slots.begin(), slots.end(), 0);
+
+        for (int i = 0; i < count; ++i)
+        {
+            int j = i + static_cast<int>(rng.bounded(static_cast<std::uint32_t>(candidates - i)));
+            std::swap(slots[i], slots[j]);
+            mines.push_back(toCell(slots[i]));
+        }
+    }
+
+    return mines;
+}
+
+bool GameState::isCorner(int index) const
+{
+    const int last = size() - 1;
+    return index == 0
+           || index == cols() - 1
+           || index == last - (cols() - 1)
+           || index == last;
+}
+
+bool GameState::reveal(int index)
+{
+    m_frontierDelta.added.clear();
+    m_frontierDelta.removed.clear();
+
+    if (!revealCell(index))
+    {
+        return false;
+    }
+
+    extendFrontier(index);
+    return true;
+}
+
+std::vector<int> GameState::revealArea(int index)
+{
+    return revealCells({&index, 1});
+}
+
+std::vector<int> GameState::revealCells(std::span<const int> indices)
+{
+    m_frontierDelta.added.clear();
+    m_frontierDelta.removed.clear();
+
+    std::vector<int> revealed;
+    for (int index : indices)
+    {
+        if (!revealCell(index))
+        {
+            continue;
+        }
+
+        revealed.push_back(index);
+
+        const int opening = openingOf(index);
+        if (opening < 0)
+        {
+            continue;
+        }
+
+        const std::span<const int> cells = openingCells(opening);
+        revealed.reserve(revealed.size() + cells.size());
+        for (int ix : cells)
+        {
+            if (revealCell(ix))
+            {
+                revealed.push_back(ix);
+            }
+        }
+    }
+
+    // Every neighbor of a zero cell was revealed with its opening, so only
+    // numbered cells can have unrevealed neighbors.  Extending the frontier
+    // after the whole batch is revealed means that no cell is added only to
+    // be removed again.
+    for (int ix : revealed)
+    {
+        if (neighboringMines(ix) > 0)
+        {
+            extendFrontier(ix);
+        }
+    }
+
+    return revealed;
+}
+
+std::vector<int> GameState::chordCells(int index) const
+{
+    std::vector<int> cells;
+    if (!isRevealed(index) || isMine(index))
+    {
+        return cells;
+    }
+
+    int flags = 0;
+    forEachNeighbor(index, [&](int n) {
+        if (isFlagged(n))
+        {
+            ++flags;
+        }
+        else if (!isRevealed(n))
+        {
+            cells.push_back(n);
+        }
+    });
+
+    if (flags != neighboringMines(index))
+    {
+        cells.clear();
+    }
+    return cells;
+}
+
+bool GameState::toggleFlag(int index)
+{
+    CellBits& cell = m_cells[index];
+    if (cell & kRevealedBit)
+    {
+        return false;
+    }
+
+    cell ^= kFlaggedBit;
+    m_knowledgeHash ^= Zobrist::key(index, Zobrist::Flag);
+    return true;
+}
+
+bool GameState::revealCell(int index)
+{
+    CellBits& cell = m_cells[index];
+    if (cell & kRevealedBit)
+    {
+        return false;
+    }
+
+    if (cell & kFlaggedBit)
+    {
+        m_knowledgeHash ^= Zobrist::key(index, Zobrist::Flag);
+    }
+
+    cell = (cell | kRevealedBit) & ~kFlaggedBit;
+
+    if (!(cell & kMineBit))
+    {
+        --m_unrevealedSafeCells;
+    }
+
+    m_knowledgeHash ^= Zobrist::key(index, (cell & kMineBit)
+        ? Zobrist::RevealedMine
+        : static_cast<Zobrist::Feature>(Zobrist::Number0 + (cell & kCountMask)));
+
+    if (m_frontier.erase(index))
+    {
+        m_frontierDelta.removed.push_back(index);
+    }
+
+    return true;
+}
+
+// Adds the unrevealed neighbors of a newly revealed cell to the frontier.  A
+// revealed mine says nothing about its neighbors, so it adds none.
+void GameState::extendFrontier(int index)
+{
+    if (isMine(index))
+    {
+        return;
+    }
+
+    forEachNeighbor(index, [this](int n) {
+        if (!isRevealed(n) && m_frontier.insert(n))
+        {
+            m_frontierDelta.added.push_back(n);
+        }
+    });
+}
+
+void GameState::placeMines(const std::vector<int>& mineIndices)
+{
+    for (int ix : mineIndices)
+    {
+        Q_ASSERT(ix >= 0 && ix < size());
+        if (!(m_cells[ix] & kMineBit))
+        {
+            m_cells[ix] |= kMineBit;
+            ++m_mineCount;
+        }
+    }
+
+    m_unrevealedSafeCells = size() - m_mineCount;
+}
+
+void GameState::countNeighboringMines()
+{
+    std::vector<CellBits> mines(m_cells.size());
+    std::vector<CellBits> counts(m_cells.size());
+
+    std::transform(m_cells.begin(), m_cells.end(), mines.begin(), [](CellBits c) {
+        return static_cast<CellBits>((c & kMineBit) != 0);
+    });
+
+    ::countNeighboringMines(mines.data(), counts.data(), rows(), cols());
+
+    std::transform(m_cells.begin(), m_cells.end(), counts.begin(), m_cells.begin(), [](CellBits c, CellBits n) {
+        return static_cast<CellBits>((c & ~kCountMask) | n);
+    });
+}
+
+void GameState::labelOpenings()
+{
+    const int n = size();
+    const int width = cols();
+
+    std::vector<std::uint8_t> zero(n);
+    std::transform(m_cells.begin(), m_cells.end(), zero.begin(), [](CellBits c) {
+        return static_cast<std::uint8_t>((c & (kMineBit | kCountMask)) == 0);
+    });
+
+    // Union-find over the zero cells, with path halving.  Each zero cell is
+    // joined to the zero cells among its neighbors that come after it in
+    // row-major order, which covers every adjacent pair exactly once.  The
+    // parent array becomes the labels, so it is built in place.
+    auto openings = std::make_shared<Openings>();
+    std::vector<int>& parent = openings->label;
+    parent.assign(n, -1);
+
+    auto find = [&](int ix) {
+        while (parent[ix] != ix)
+        {
+            parent[ix] = parent[parent[ix]];
+            ix = parent[ix];
+        }
+        return ix;
+    };
+    auto unite = [&](int a, int b) {
+        a = find(a);
+        b = find(b);
+        if (a != b)
+        {
+            parent[std::max(a, b)] = std::min(a, b);
+        }
+    };
+
+    for (int ix = 0; ix < n; ++ix)
+    {
+        parent[ix] = zero[ix] ? ix : -1;
+    }
+
+    // Links that are implied by others are skipped: a diagonal neighbor below
+    // is reached through the cell beside it whenever that cell is also zero.
+    const int lastRow = rows() - 1;
+    for (int y = 0; y < rows(); ++y)
+    {
+        const int row = y * width;
+        for (int x = 0; x < width; ++x)
+        {
+            const int ix = row + x;
+            if (!zero[ix])
+            {
+                continue;
+            }
+
+            const bool right = x + 1 < width && zero[ix + 1];
+            if (right)
+            {
+                unite(ix, ix + 1);
+            }
+            if (y == lastRow)
+            {
+                continue;
+            }
+
+            const int below = ix + width;
+            if (zero[below])
+            {
+                unite(ix, below);
+                continue;
+            }
+            if (x > 0 && !zero[ix - 1] && zero[below - 1])
+            {
+                unite(ix, below - 1);
+            }
+            if (x + 1 < width && !right && zero[below + 1])
+            {
+                unite(ix, below + 1);
+            }
+        }
+    }
+
+    // Every cell's parent precedes it, so in row-major order each parent has
+    // already been replaced by its label by the time its children need it,
+    // and a root is simply a cell that is its own parent.
+    int count = 0;
+    for (int ix = 0; ix < n; ++ix)
+    {
+        if (zero[ix])
+        {
+            parent[ix] = parent[ix] == ix ? count++ : parent[parent[ix]];
+        }
+    }
+    const std::vector<int>& label = openings->label;
+
+    // Gather each opening's cells, zero and border alike, in row-major order,
+    // by counting sort.  A numbered cell borders an opening exactly when it
+    // has a zero neighbor, which the same kernel that counts mines finds in
+    // bulk; only those cells need their neighbors' labels examined, once,
+    // with the distinct labels found kept for the second pass.
+    std::vector<std::uint8_t> bordered(n);
+    ::countNeighboringMines(zero.data(), bordered.data(), rows(), width);
+
+    std::vector<int>& start = openings->start;
+    start.assign(count + 1, 0);
+
+    const int interiorOffsets[] = {-width - 1, -width, -width + 1, -1, 1, width - 1, width, width + 1};
+
+    std::vector<int> borderLabels;
+    for (int y = 0; y < rows(); ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            const int ix = y * width + x;
+            if (zero[ix])
+            {
+                ++start[label[ix] + 1];
+            }
+            else if (isMine(ix))
+            {
+                bordered[ix] = 0;
+            }
+            else if (bordered[ix] == 0)
+            {
+                ++openings->isolatedNumbers;
+            }
+            else
+            {
+                // A numbered cell borders at most four distinct openings, and
+                // nearly always just one: that case is settled without branching
+                // on each neighbor, from the smallest and largest labels around.
+                // Non-zero cells are labelled -1, which is the largest of all
+                // when compared unsigned.
+                int found[4];
+                int distinct = 0;
+                auto visit = [&](int neighbor) {
+                    const int l = label[neighbor];
+                    if (l >= 0 && std::find(found, found + distinct, l) == found + distinct)
+                    {
+                        found[distinct++] = l;
+                    }
+                };
+
+                if (y > 0 && y < lastRow && x > 0 && x < width - 1)
+                {
+                    unsigned lowest = static_cast<unsigned>(-1);
+                    int highest = -1;
+                    for (int offset : interiorOffsets)
+                    {
+                        const int l = label[ix + offset];
+                        lowest = std::min(lowest, static_cast<unsigned>(l));
+                        highest = std::max(highest, l);
+                    }
+
+                    if (static_cast<int>(lowest) == highest)
+                    {
+                        found[distinct++] = highest;
+                    }
+                    else
+                    {
+                        for (int offset : interiorOffsets)
+                        {
+                            visit(ix + offset);
+                        }
+                    }
+                }
+                else
+                {
+                    forEachNeighbor(ix, visit);
+                }
+
+                for (int i = 0; i < distinct; ++i)
+                {
+                    borderLabels.push_back(found[i]);
+                    ++start[found[i] + 1];
+                }
+                bordered[ix] = static_cast<std::uint8_t>(distinct);
+            }
+        }
+    }
+
+    std::partial_sum(start.begin(), start.end(), start.begin());
+
+    std::vector<int> next(start.begin(), start.end() - 1);
+    openings->cells.resize(start.back());
+
+    auto borderLabel = borderLabels.begin();
+    for (int ix = 0; ix < n; ++ix)
+    {
+        if (zero[ix])
+        {
+            openings->cells[next[label[ix]]++] = ix;
+        }
+        else
+        {
+            for (int i = 0; i < bordered[ix]; ++i)
+            {
+                openings->cells[next[*borderLabel++]++] = ix;
+            }
+        }
+    }
+
+    m_openings = std::move(openings);
+}
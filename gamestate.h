@@ -0,0 +1,277 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef GAMESTATE_H
+#define GAMESTATE_H
+
+#include "cellset.h"
+#include "gameboard.h"
+#include "rng.h"
+
+#include <QPoint>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+/**
+ * @brief The GameState class holds the complete state of one game, with no
+ *        dependency on any UI.
+ *
+ * Cells are stored row-major, one byte apiece:
+ *
+ *   bits 0-3: the number of neighboring mines
+ *   bit 4:    set if the cell is a mine
+ *   bit 5:    set if the cell has been revealed
+ *   bit 6:    set if the cell has been flagged
+ *
+ * When the mines are laid, the board's openings are labelled: each maximal
+ * connected region of zero cells, together with the numbered cells bordering
+ * it, which is exactly what revealing any of its zero cells opens.  The
+ * labels are never modified afterwards, so copies of a state share them.
+ *
+ * The frontier, every unrevealed cell next to a revealed safe cell, is kept
+ * up to date as cells are revealed, so that whatever reasons about the board
+ * can visit just those cells instead of rescanning it.  Flags play no part
+ * in it: like the solver, the frontier only trusts revealed cells.
+ */
+class GameState
+{
+public:
+    using CellBits = std::uint8_t;
+
+    static constexpr CellBits kCountMask = 0x0F;
+    static constexpr CellBits kMineBit = 0x10;
+    static constexpr CellBits kRevealedBit = 0x20;
+    static constexpr CellBits kFlaggedBit = 0x40;
+
+    /**
+     * @brief Creates a new game, with mines placed at random in every cell but the corners.
+     */
+    explicit GameState(GameBoard board);
+
+    /**
+     * @brief Creates the game that the given seed produces; the same board and
+     *        seed always yield the same mines.
+     */
+    GameState(GameBoard board, std::uint64_t seed);
+
+    /**
+     * @brief Creates a new game with mines in exactly the given cells.
+     */
+    GameState(GameBoard board, const std::vector<int>& mineIndices);
+
+    /**
+     * @brief Chooses board.mines() distinct cells, none of them corners, uniformly at random.
+     *
+     * Draws exactly one random number per mine.  Very sparse boards also use
+     * memory proportional only to the number of mines.
+     */
+    static std::vector<int> chooseMines(const GameBoard& board, Rng& rng);
+
+    const GameBoard& board() const { return m_board; }
+
+    /**
+     * @brief The seed that generated this game, or 0 if its mines were given explicitly.
+     */
+    std::uint64_t seed() const { return m_seed; }
+
+    int rows() const { return m_board.rows(); }
+    int cols() const { return m_board.cols(); }
+    int size() const { return static_cast<int>(m_cells.size()); }
+
+    int indexOf(const QPoint& coord) const { return coord.y() * cols() + coord.x(); }
+    QPoint pointOf(int index) const { return QPoint{index % cols(), index / cols()}; }
+
+    bool contains(const QPoint& coord) const
+    {
+        return coord.x() >= 0 && coord.x() < cols() && coord.y() >= 0 && coord.y() < rows();
+    }
+
+    bool isCorner(int index) const;
+
+    bool isMine(int index) const { return (m_cells[index] & kMineBit) != 0; }
+    bool isRevealed(int index) const { return (m_cells[index] & kRevealedBit) != 0; }
+    bool isFlagged(int index) const { return (m_cells[index] & kFlaggedBit) != 0; }
+    int neighboringMines(int index) const { return m_cells[index] & kCountMask; }
+
+    /**
+     * @brief Marks the given cell as revealed, clearing any flag on it.
+     * @return true if the cell was not already revealed.
+     */
+    bool reveal(int index);
+
+    /**
+     * @brief Reveals a cell and, if it has no neighboring mines, the whole opening
+     *        around it: every connected zero cell plus its numbered border.
+     *
+     * Openings are labelled when the mines are laid, so this reveals the
+     * opening's cells directly rather than searching for them.
+     *
+     * @return the indices of every cell that this call revealed; the given
+     *         cell first, then the rest of any opening in row-major order.
+     */
+    std::vector<int> revealArea(int index);
+
+    /**
+     * @brief Reveals several cells in one pass, each as revealArea() would,
+     *        with a single update to the frontier for the whole batch.
+     *
+     * @return the indices of every cell that this call revealed, each once.
+     */
+    std::vector<int> revealCells(std::span<const int> indices);
+
+    /**
+     * @brief The cells that chording on the given cell would reveal: if it is
+     *        a revealed number with exactly that many flagged neighbors, its
+     *        other unrevealed neighbors; otherwise none.
+     *
+     * Like a player's chord, this trusts the flags; a wrong one means a mine
+     * is among the cells returned.
+     */
+    std::vector<int> chordCells(int index) const;
+
+    /**
+     * @brief The unrevealed cells with at least one revealed neighbor that isn't a mine.
+     */
+    const CellSet& frontier() const { return m_frontier; }
+
+    struct FrontierDelta
+    {
+        std::vector<int> added;
+        std::vector<int> removed;
+    };
+
+    /**
+     * @brief How the frontier changed in the most recent call to reveal(),
+     *        revealArea() or revealCells().  A cell that joined and left
+     *        within that call appears in neither list.
+     */
+    const FrontierDelta& frontierDelta() const { return m_frontierDelta; }
+
+    /**
+     * @brief A Zobrist hash of everything the player can see: which cells are
+     *        revealed, with their numbers, and which are flagged.  Updated in
+     *        constant time by every reveal and flag, so positions can key
+     *        caches cheaply.  A new game hashes to 0.
+     */
+    std::uint64_t knowledgeHash() const { return m_knowledgeHash; }
+
+    /**
+     * @brief Flags or unflags an unrevealed cell.
+     * @return true if the flag changed.
+     */
+    bool toggleFlag(int index);
+
+    /**
+     * @brief Returns true if every cell that isn't a mine has been revealed.
+     */
+    bool isSolved() const { return m_unrevealedSafeCells == 0; }
+
+    int mineCount() const { return m_mineCount; }
+
+    /**
+     * @brief The number of cells that are not mines and have yet to be revealed.
+     */
+    int remainingSafeCells() const { return m_unrevealedSafeCells; }
+
+    /**
+     * @brief The number of openings on the board.
+     */
+    int openingCount() const { return static_cast<int>(m_openings->start.size()) - 1; }
+
+    /**
+     * @brief The opening whose zero cells include the given cell, or -1 if the
+     *        cell is a mine or has neighboring mines.
+     */
+    int openingOf(int index) const { return m_openings->label[index]; }
+
+    /**
+     * @brief Every cell of an opening, zero and border alike, in row-major order.
+     */
+    std::span<const int> openingCells(int opening) const
+    {
+        const int* first = m_openings->cells.data() + m_openings->start[opening];
+        return {first, first + (m_openings->start[opening + 1] - m_openings->start[opening])};
+    }
+
+    /**
+     * @brief The board's 3BV (Bechtel's Board Benchmark Value): the fewest
+     *        clicks that clear it, one per opening plus one per numbered cell
+     *        that borders no opening.
+     */
+    int threeBV() const { return openingCount() + m_openings->isolatedNumbers; }
+
+    /**
+     * @brief Raw access to the packed cells, for consumers that want to scan
+     *        the board without going through the per-cell accessors.
+     */
+    const std::vector<CellBits>& cells() const { return m_cells; }
+
+    /**
+     * @brief Invokes fn(int neighborIndex) for each in-bounds neighbor of the given cell.
+     */
+    template <typename Fn>
+    void forEachNeighbor(int index, Fn&& fn) const
+    {
+        const int x = index % cols();
+        const int y = index / cols();
+        const int xmin = x > 0 ? x - 1 : x;
+        const int xmax = x < cols() - 1 ? x + 1 : x;
+        const int ymin = y > 0 ? y - 1 : y;
+        const int ymax = y < rows() - 1 ? y + 1 : y;
+
+        for (int ny = ymin; ny <= ymax; ++ny)
+        {
+            for (int nx = xmin; nx <= xmax; ++nx)
+            {
+                if (nx != x || ny != y)
+                {
+                    fn(ny * cols() + nx);
+                }
+            }
+        }
+    }
+
+private:
+    struct Openings
+    {
+        std::vector<int> label; // per cell: its opening if a zero cell, else -1
+        std::vector<int> start; // opening i's cells are cells[start[i], start[i + 1])
+        std::vector<int> cells;
+        int isolatedNumbers{};
+    };
+
+    void placeMines(const std::vector<int>& mineIndices);
+    void countNeighboringMines();
+    void labelOpenings();
+    bool revealCell(int index);
+    void extendFrontier(int index);
+
+    GameBoard m_board;
+    std::uint64_t m_seed;
+    std::vector<CellBits> m_cells;
+    std::shared_ptr<const Openings> m_openings;
+    CellSet m_frontier;
+    FrontierDelta m_frontierDelta;
+    std::uint64_t m_knowledgeHash;
+    int m_mineCount;
+    int m_unrevealedSafeCells;
+};
+
+#endif // GAMESTATE_H
@@ -0,0 +1,154 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "hint.h"
+
+#include "constraintproblem.h"
+#include "solver.h"
+
+#include <vector>
+
+namespace {
+
+// Long enough for a useful estimate, short enough that a hint still feels
+// prompt when the frontier is too large to enumerate.
+constexpr qint64 kEstimateTimeMs = 200;
+
+MonteCarloEstimator::Budget estimateBudget()
+{
+    MonteCarloEstimator::Budget budget;
+    budget.timeMs = kEstimateTimeMs;
+    return budget;
+}
+
+// The unknown, unflagged cell with the lowest probability, the first in
+// row-major order among equals, or -1 if there is none.  The unknown cells
+// are those of the problem's components and its interior; the interior cells
+// all share one probability, so the first unflagged one stands for the rest.
+// A flag is the player's own call, so a flagged cell is never suggested.
+int leastLikelyMine(const GameState& state, const ConstraintProblem& problem, const std::vector<double>& mineProbability)
+{
+    int best = -1;
+    auto consider = [&](int ix) {
+        if (state.isFlagged(ix))
+        {
+            return false;
+        }
+
+        if (best < 0
+            || mineProbability[ix] < mineProbability[best]
+            || (mineProbability[ix] == mineProbability[best] && ix < best))
+        {
+            best = ix;
+        }
+        return true;
+    };
+
+    for (const ConstraintProblem::Component& component : problem.components)
+    {
+        for (int ix : component.cells)
+        {
+            consider(ix);
+        }
+    }
+
+    for (int ix : problem.interior)
+    {
+        if (consider(ix))
+        {
+            break;
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+HintFinder::HintFinder()
+    : m_estimator{estimateBudget()}
+{
+}
+
+std::optional<HintFinder::Hint> HintFinder::find(const GameState& state, const std::function<bool()>& isCanceled) const
+{
+    auto canceled = [&isCanceled]() { return isCanceled && isCanceled(); };
+
+    const Solver solver{state};
+    const std::vector<int> safe = solver.safeCells();
+    if (!safe.empty())
+    {
+        return Hint{safe.front(), true, 0.0};
+    }
+
+    if (canceled())
+    {
+        return std::nullopt;
+    }
+
+    const ConstraintProblem problem = ConstraintProblem::fromState(state, &solver);
+    const ProbabilityEngine::Result exact = m_engine.compute(state, problem, isCanceled);
+    if (exact.canceled)
+    {
+        return std::nullopt;
+    }
+    std::vector<double> mineProbability = exact.mineProbability;
+
+    if (!exact.exact)
+    {
+        const MonteCarloEstimator::Result estimate = m_estimator.estimate(state, problem, isCanceled);
+        if (estimate.canceled)
+        {
+            return std::nullopt;
+        }
+        if (estimate.consistent)
+        {
+            mineProbability = estimate.mineProbability;
+        }
+    }
+
+    if (canceled())
+    {
+        return std::nullopt;
+    }
+
+    // Before the first move nothing is visible to tell the cells apart, and
+    // generated boards keep their corners clear, so a corner is the natural
+    // opening.  Nothing the player can see proves that, so it is still only a
+    // guess, with the probability of any other cell.
+    if (state.remainingSafeCells() == state.size() - state.mineCount())
+    {
+        const int corners[] = {0, state.cols() - 1, state.size() - state.cols(), state.size() - 1};
+        for (int corner : corners)
+        {
+            if (!state.isFlagged(corner))
+            {
+                return Hint{corner, false, mineProbability[corner]};
+            }
+        }
+    }
+
+    const int best = leastLikelyMine(state, problem, mineProbability);
+    if (best < 0)
+    {
+        return std::nullopt;
+    }
+
+    // An exact probability of zero means no configuration at all puts a mine
+    // there, which proves it safe as surely as the Solver would have.
+    const bool proven = exact.exact && mineProbability[best] == 0.0;
+    return Hint{best, proven, mineProbability[best]};
+}
@@ -0,0 +1,78 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef HINT_H
+#define HINT_H
+
+#include "gamestate.h"
+#include "montecarlo.h"
+#include "probability.h"
+
+#include <functional>
+#include <optional>
+
+/**
+ * @brief Suggests the player's next move: a cell that is certainly safe if
+ *        there is one, and otherwise the cell least likely to be a mine.
+ *
+ * Works in stages, each more expensive than the last, and stops at the first
+ * that gives an answer:
+ *
+ *   - a cell the Solver proves safe;
+ *   - the lowest exact probability from a ProbabilityEngine, which proves
+ *     the cell safe if it is zero;
+ *   - failing that, the lowest estimate from a MonteCarloEstimator.
+ *
+ * A guess is never a flagged cell.  Before anything is revealed, when every
+ * cell is as likely as the next, it is an unflagged corner.
+ *
+ * Meant to be run off the UI thread.  Cancellation is checked between
+ * stages, and within them between the engine's DP layers and the
+ * estimator's batches of samples, so a cancelled search ends within about
+ * one layer or batch.
+ *
+ * find() may be called from several threads at once.  Keeping one finder
+ * from hint to hint lets each reuse the component counts of the last,
+ * through the ProbabilityEngine's cache.
+ */
+class HintFinder
+{
+public:
+    struct Hint
+    {
+        int cell{-1};
+        bool safe{};               // proven safe, rather than merely the best guess
+        double mineProbability{};  // 0 when safe
+    };
+
+    HintFinder();
+
+    /**
+     * @brief Finds a hint for a game in progress.
+     * @param isCanceled polled between stages and within them, possibly from
+     *        several threads at once; once it returns true, the search gives
+     *        up and returns nothing.
+     * @return the hint, or nothing if cancelled or no cell is left unrevealed.
+     */
+    std::optional<Hint> find(const GameState& state, const std::function<bool()>& isCanceled = {}) const;
+
+private:
+    ProbabilityEngine m_engine;
+    MonteCarloEstimator m_estimator;
+};
+
+#endif // HINT_H
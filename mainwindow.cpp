@@ -19,44 +19,249 @@
 
 #include "aboutdialog.h"
 #include "customgamedialog.h"
+#include "endlessfield.h"
 #include "minefield.h"
-
-#include <QDebug>
+#include "noguess.h"
+#include "replayplayer.h"
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileDialog>
 #include <QGridLayout>
+#include <QInputDialog>
 #include <QMenu>
 #include <QMenuBar>
 #include <QMessageBox>
+#include <QtConcurrent>
 #include <QSettings>
+#include <QStatusBar>
+#include <QStandardPaths>
 #include <QVariant>
 
 #include <QtGlobal>
 
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
 namespace {
 
 constexpr const int kCellSize = 30;
 
-constexpr const GameBoard kSmallGame{10, 10, 15};
-constexpr const GameBoard kMediumGame{15, 15, 45};
-constexpr const GameBoard kLargeGame{16, 30, 99};
+// How long a hint may take before the busy cursor goes up: about one frame.
+constexpr const int kHintBusyDelayMs = 16;
+
+// Where a game in progress is kept between runs.
+QString savedGamePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/game.sav");
+}
+
+// Where the statistics of every finished game are kept.
+QString statsLogPath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/stats.log");
+}
+
+// Where every finished game's recording is kept.
+QString replayDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/replays");
+}
 
 } // namespace
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
+    , m_noGuess{false}
+    , m_endless{false}
+    , m_replaying{false}
+    , m_prefetchNoGuess{false}
+    , m_deal{nullptr}
+    , m_hintFinder{std::make_shared<HintFinder>()}
+    , m_hintWatcher{new QFutureWatcher<HintFinder::Hint>(this)}
+    , m_hintBusyTimer{new QTimer(this)}
+    , m_hintWanted{false}
     , m_about{nullptr}
+    , m_statsDialog{nullptr}
     , m_clock{new Clock(this)}
+    , m_time{new QLabel(this)}
+    , m_score{new QLabel(this)}
+    , m_savedNoGuess{false}
+    , m_stats{statsLogPath(), &m_background}
 {
     QSettings settings;
     GameBoard size;
     size.load(settings);
+    m_noGuess = settings.value("noGuess", false).toBool();
+    m_savedBoard = size;
+    m_savedNoGuess = m_noGuess;
+
+    // One thread, so that writes land in the order they were made.
+    m_background.setMaxThreadCount(1);
+
+    if (!QDir{}.mkpath(QFileInfo{statsLogPath()}.absolutePath()) || !m_stats.load())
+    {
+        qWarning("Couldn't read the statistics in %s; this session's games won't be recorded", qPrintable(statsLogPath()));
+    }
 
     setWindowTitle(tr("Mines"));
     initializeActions();
     initializeMenu();
 
+    // A label repaints only itself, and only while it can be seen, where a
+    // new window title goes out to the window manager every second.
+    statusBar()->setSizeGripEnabled(false);
+    statusBar()->addWidget(m_score);
+    statusBar()->addPermanentWidget(m_time);
+    m_score->hide();
+    clockTicked(0);
+
     connect(m_clock, &Clock::tick, this, &MainWindow::clockTicked);
+    connect(m_clock, &Clock::didReset, this, [this]() { clockTicked(0); });
+
+    m_hintBusyTimer->setSingleShot(true);
+    m_hintBusyTimer->setInterval(kHintBusyDelayMs);
+    connect(m_hintBusyTimer, &QTimer::timeout, this, [this]() {
+        if (m_hintWatcher->isRunning() && centralWidget() != nullptr)
+        {
+            centralWidget()->setCursor(Qt::BusyCursor);
+        }
+    });
+    connect(m_hintWatcher, &QFutureWatcher<HintFinder::Hint>::finished, this, &MainWindow::hintFound);
+
+    // Hiding covers closing the window and, on most platforms, minimizing
+    // it; quitting covers the rest, such as logging out with the window open.
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &MainWindow::saveGame);
+
+    if (!resumeGame())
+    {
+        initializeGame(size);
+    }
+}
+
+void MainWindow::hideEvent(QHideEvent* event)
+{
+    // Nobody can see the clock, so there's no need for it to wake us.
+    m_clock->setDisplayed(false);
+
+    saveGame();
+    QMainWindow::hideEvent(event);
+}
+
+void MainWindow::showEvent(QShowEvent* event)
+{
+    m_clock->setDisplayed(true);
+    QMainWindow::showEvent(event);
+}
+
+void MainWindow::saveGame()
+{
+    const QString path = savedGamePath();
+
+    // Only a game that is under way is worth coming back to; anything else
+    // clears out whatever was saved before.
+    const MineField* field = qobject_cast<MineField*>(centralWidget());
+    if (field == nullptr || m_replaying || !field->isInProgress())
+    {
+        QFile::remove(path);
+        return;
+    }
+
+    if (!QDir{}.mkpath(QFileInfo{path}.absolutePath()) || !SaveGame::save(path, field->state(), m_clock->elapsedNs() / 1000))
+    {
+        qWarning("Couldn't save the game in progress to %s", qPrintable(path));
+    }
+}
+
+bool MainWindow::resumeGame()
+{
+    std::optional<SaveGame::Snapshot> snapshot = SaveGame::load(savedGamePath());
+    if (!snapshot)
+    {
+        return false;
+    }
+
+    const GameState& state = snapshot->state;
+    for (int ix = 0; ix < state.size(); ++ix)
+    {
+        if (state.isRevealed(ix) && state.isMine(ix))
+        {
+            return false; // never saved that way, but not worth resuming if it was
+        }
+    }
+
+    const GameBoard board{state.rows(), state.cols(), state.mineCount()};
+    const qint64 elapsedUs = snapshot->elapsedUs;
+    initializeGame(board, std::move(snapshot->state));
+
+    // The clock picks up again with the first move, as in a new game.
+    m_clock->restore(std::chrono::nanoseconds{std::chrono::microseconds{elapsedUs}}.count());
+    return true;
+}
+
+void MainWindow::saveRecording()
+{
+    const MineField* field = qobject_cast<MineField*>(centralWidget());
+    if (field == nullptr || m_replaying || !field->recording())
+    {
+        return;
+    }
+
+    const QString directory = replayDirectory();
+    const QString path = directory + QDateTime::currentDateTime().toString(QStringLiteral("/yyyyMMdd-hhmmss.zzz")) + QStringLiteral(".mrec");
+    if (!QDir{}.mkpath(directory) || !field->recording()->save(path))
+    {
+        qWarning("Couldn't save the recording of this game to %s", qPrintable(path));
+    }
+}
+
+void MainWindow::openReplay()
+{
+    const QString path = QFileDialog::getOpenFileName(this, tr("Watch Replay"), replayDirectory(), tr("Mines recordings (*.mrec)"));
+    if (path.isEmpty())
+    {
+        return;
+    }
+
+    std::optional<Recording> recording = Recording::load(path);
+    if (!recording || !recording->verify().valid)
+    {
+        QMessageBox::warning(this, tr("Watch Replay"), tr("That file is damaged, or isn't a recording of a game of Mines."));
+        return;
+    }
+
+    const QStringList speeds{tr("Real time"), tr("10x"), tr("As fast as possible")};
+    bool ok = false;
+    const QString speed = QInputDialog::getItem(this, tr("Watch Replay"), tr("Speed:"), speeds, 0, false, &ok);
+    if (!ok)
+    {
+        return;
+    }
 
-    initializeGame(size);
+    startReplay(std::move(*recording), speed == speeds[0] ? 1.0 : speed == speeds[1] ? 10.0 : ReplayPlayer::kAsFastAsPossible);
+}
+
+void MainWindow::recordGame(bool won)
+{
+    const MineField* field = qobject_cast<MineField*>(centralWidget());
+    if (field == nullptr || m_replaying)
+    {
+        return;
+    }
+
+    m_stats.append(StatsLog::Game{
+        m_board,
+        field->state().seed(),
+        won,
+        m_clock->elapsedNs() / 1000,
+        field->moves(),
+        field->state().threeBV(),
+        QDateTime::currentMSecsSinceEpoch(),
+    });
 }
 
 void MainWindow::showAboutDialog()
@@ -71,6 +276,18 @@ void MainWindow::showAboutDialog()
     m_about->activateWindow();
 }
 
+void MainWindow::showStatsDialog()
+{
+    if (m_statsDialog == nullptr)
+    {
+        m_statsDialog = new StatsDialog{m_stats, this};
+    }
+
+    m_statsDialog->show();
+    m_statsDialog->raise();
+    m_statsDialog->activateWindow();
+}
+
 void MainWindow::initializeActions()
 {
     m_smallGame = new QAction;
@@ -93,11 +310,40 @@ void MainWindow::initializeActions()
     m_customGame->setCheckable(true);
     connect(m_customGame, &QAction::triggered, this, &MainWindow::beginCustomGame);
 
+    m_endlessGame = new QAction;
+    m_endlessGame->setText(tr("Endless"));
+    m_endlessGame->setStatusTip(tr("Play on a board without edges, for as long as you can avoid the mines"));
+    m_endlessGame->setCheckable(true);
+    connect(m_endlessGame, &QAction::triggered, this, &MainWindow::initializeEndlessGame);
+
+    m_noGuessGame = new QAction;
+    m_noGuessGame->setText(tr("No Guessing"));
+    m_noGuessGame->setStatusTip(tr("Only deal boards that can be cleared without guessing, starting from the top-left corner"));
+    m_noGuessGame->setCheckable(true);
+    connect(m_noGuessGame, &QAction::toggled, this, &MainWindow::setNoGuess);
+
+    m_hint = new QAction;
+    m_hint->setText(tr("&Hint"));
+    m_hint->setShortcut(Qt::Key_H);
+    m_hint->setStatusTip(tr("Highlight a safe cell, or if there is none, the one least likely to be a mine"));
+    connect(m_hint, &QAction::triggered, this, &MainWindow::requestHint);
+
+    m_replay = new QAction;
+    m_replay->setText(tr("Watch &Replay..."));
+    m_replay->setStatusTip(tr("Play back a recording of an earlier game"));
+    connect(m_replay, &QAction::triggered, this, &MainWindow::openReplay);
+
+    m_statistics = new QAction;
+    m_statistics->setText(tr("&Statistics"));
+    m_statistics->setStatusTip(tr("Show win rates, best times and streaks for each board size"));
+    connect(m_statistics, &QAction::triggered, this, &MainWindow::showStatsDialog);
+
     m_gameSizeGroup = new QActionGroup(this);
     m_gameSizeGroup->addAction(m_smallGame);
     m_gameSizeGroup->addAction(m_mediumGame);
     m_gameSizeGroup->addAction(m_largeGame);
     m_gameSizeGroup->addAction(m_customGame);
+    m_gameSizeGroup->addAction(m_endlessGame);
 }
 
 void MainWindow::initializeMenu()
@@ -115,6 +361,17 @@ void MainWindow::initializeMenu()
     file->addAction(m_mediumGame);
     file->addAction(m_largeGame);
     file->addAction(m_customGame);
+    file->addAction(m_endlessGame);
+
+    file->addSeparator();
+
+    file->addAction(m_noGuessGame);
+
+    file->addSeparator();
+
+    file->addAction(m_hint);
+    file->addAction(m_replay);
+    file->addAction(m_statistics);
 
     file->addSeparator();
 
@@ -141,33 +398,158 @@ void MainWindow::beginCustomGame(bool checked)
     }
 }
 
-void MainWindow::initializeGame(GameBoard board)
+void MainWindow::setNoGuess(bool noGuess)
+{
+    if (noGuess == m_noGuess)
+    {
+        return;
+    }
+
+    m_noGuess = noGuess;
+    saveSettings();
+
+    // Applies from the next game on; the prefetched one was dealt under the
+    // old setting.
+    cancelPrefetch();
+    prefetchNextGame();
+}
+
+void MainWindow::initializeGame(GameBoard board, std::optional<GameState> resumed)
 {
+    if (board != m_board)
+    {
+        cancelPrefetch();
+    }
+
     m_board = board;
-    initializeGrid();
+    m_endless = false;
+    m_replaying = false;
+    m_hint->setEnabled(true);
+    initializeGrid(std::move(resumed));
+
+    fitToField(kCellSize * cols(), kCellSize * rows());
+
+    updateMenuCheckboxes();
+    m_noGuessGame->setChecked(m_noGuess);
+
+    saveSettings();
+}
+
+void MainWindow::initializeEndlessGame()
+{
+    m_endless = true;
+    m_replaying = false;
+    cancelDeal();
+
+    if (centralWidget() != nullptr)
+    {
+        centralWidget()->deleteLater();
+        setCentralWidget(nullptr);
+    }
+
+    m_clock->reset();
+
+    // Hints need the whole board to reason about, which an endless one
+    // never has.
+    m_hintWanted = false;
+    cancelHint();
+    m_hint->setEnabled(false);
 
-    int fixedWidth = kCellSize * cols();
-    int fixedHeight = kCellSize * rows();
+    EndlessField* field = new EndlessField(Rng::randomSeed(), this);
 
+    connect(field, &EndlessField::gameLost, this, &MainWindow::lose);
+    connect(field, &EndlessField::clearedChanged, this, [this](qint64 cleared) {
+        m_score->setText(tr("%n cell(s) cleared", nullptr, static_cast<int>(cleared)));
+    });
+    m_score->setText(tr("%n cell(s) cleared", nullptr, 0));
+    m_score->show();
+
+    connect(field, &EndlessField::gameStarted, m_clock, &Clock::resume);
+    connect(field, &EndlessField::gameLost, m_clock, &Clock::pause);
+
+    setCentralWidget(field);
+    field->setFocus();
+
+    fitToField(field->width(), field->height());
+    updateMenuCheckboxes();
+}
+
+void MainWindow::startReplay(Recording recording, double speed)
+{
+    m_replaying = true;
+    cancelDeal();
+
+    if (centralWidget() != nullptr)
+    {
+        centralWidget()->deleteLater();
+        setCentralWidget(nullptr);
+    }
+
+    m_clock->reset();
+    m_score->hide();
+
+    m_hintWanted = false;
+    cancelHint();
+    m_hint->setEnabled(false);
+
+    const GameBoard board = recording.board();
+    MineField* field = new MineField(GameState{board, recording.seed()}, this);
+
+    // Watched, not played.
+    field->setAttribute(Qt::WA_TransparentForMouseEvents);
+
+    // The clock can't keep up with a sped-up replay, so it just shows the
+    // recorded time once the replay is over.
+    const qint64 elapsedNs = recording.moves().empty() ? 0 : recording.moves().back().timeUs * 1000;
+    ReplayPlayer* player = new ReplayPlayer(std::move(recording), field, speed);
+    connect(player, &ReplayPlayer::finished, m_clock, [this, elapsedNs]() { m_clock->restore(elapsedNs); });
+
+    setCentralWidget(field);
+    fitToField(kCellSize * board.cols(), kCellSize * board.rows());
+
+    player->start();
+}
+
+void MainWindow::fitToField(int width, int height)
+{
 #ifndef Q_OS_MACOS
     // macOS uses "global" menu bars at the top of the screen;
     // other platforms have menubars attached at the top of each
     // window.  If we're not on macOS, we need to account for the
     // height of the menu bar or else cells end up squished.
-    fixedHeight += menuWidget()->height();
+    height += menuWidget()->height();
 #endif
+    height += statusBar()->sizeHint().height();
+
+    setFixedSize(width, height);
+}
 
-    setFixedSize(fixedWidth, fixedHeight);
+void MainWindow::saveSettings()
+{
+    if (m_board == m_savedBoard && m_noGuess == m_savedNoGuess)
+    {
+        return;
+    }
 
-    updateMenuCheckboxes();
+    m_savedBoard = m_board;
+    m_savedNoGuess = m_noGuess;
 
-    QSettings settings;
-    board.save(settings);
+    // QSettings goes to disk when it is destroyed, so let that happen on the
+    // background thread.
+    m_background.start([board = m_board, noGuess = m_noGuess]() mutable {
+        QSettings settings;
+        board.save(settings);
+        settings.setValue("noGuess", noGuess);
+    });
 }
 
 void MainWindow::updateMenuCheckboxes()
 {
-    if (m_board == kSmallGame)
+    if (m_endless)
+    {
+        m_endlessGame->setChecked(true);
+    }
+    else if (m_board == kSmallGame)
     {
         m_smallGame->setChecked(true);
     }
@@ -185,8 +567,10 @@ void MainWindow::updateMenuCheckboxes()
     }
 }
 
-void MainWindow::initializeGrid()
+void MainWindow::initializeGrid(std::optional<GameState> resumed)
 {
+    cancelDeal();
+
     if (centralWidget() != nullptr)
     {
         centralWidget()->deleteLater();
@@ -194,8 +578,53 @@ void MainWindow::initializeGrid()
     }
 
     m_clock->reset();
+    m_score->hide();
 
-    MineField* field = new MineField(m_board, this);
+    m_hintWanted = false;
+    cancelHint();
+
+    if (resumed)
+    {
+        showField(std::move(*resumed));
+        return;
+    }
+
+    QFuture<Deal> next = takeNextGame();
+    if (next.isFinished() || !m_noGuess)
+    {
+        // An ordinary board is dealt in far less than a frame, so it isn't
+        // worth the round trip through the event loop.
+        Deal deal = next.takeResult();
+        showField(std::move(deal.state), deal.start);
+        return;
+    }
+
+    // A no-guess board can take a while to find, and the window stays
+    // responsive, if empty, until it turns up.
+    setCursor(Qt::BusyCursor);
+
+    m_deal = new QFutureWatcher<Deal>(this);
+    connect(m_deal, &QFutureWatcher<Deal>::finished, this, [this]() {
+        QFutureWatcher<Deal>* deal = std::exchange(m_deal, nullptr);
+        deal->deleteLater();
+        unsetCursor();
+
+        Deal next = deal->future().takeResult();
+        showField(std::move(next.state), next.start);
+    });
+    m_deal->setFuture(next);
+}
+
+void MainWindow::showField(GameState state, int start)
+{
+    MineField* field = new MineField(std::move(state), this);
+
+    // A no-guess board is only sure to need no guess from its start cell,
+    // so that is where the player is pointed, until the first reveal.
+    if (start >= 0)
+    {
+        field->showHint(start, true);
+    }
 
     connect(field, &MineField::gameWon, this, &MainWindow::win);
     connect(field, &MineField::gameLost, this, &MainWindow::lose);
@@ -204,7 +633,153 @@ void MainWindow::initializeGrid()
     connect(field, &MineField::gameWon, m_clock, &Clock::pause);
     connect(field, &MineField::gameLost, m_clock, &Clock::pause);
 
+    // A hint still on its way was found for a position that no longer
+    // stands, so start again from the new one.
+    auto restartHint = [this]() {
+        if (m_hintWanted)
+        {
+            startHint();
+        }
+    };
+    connect(field, &MineField::cellsRevealed, this, restartHint);
+    connect(field, &MineField::flagToggled, this, restartHint);
+
     setCentralWidget(field);
+
+    prefetchNextGame();
+}
+
+void MainWindow::cancelDeal()
+{
+    if (m_deal == nullptr)
+    {
+        return;
+    }
+
+    // Deleting the watcher first means no one hears the cancelled search end.
+    QFutureWatcher<Deal>* deal = std::exchange(m_deal, nullptr);
+    QFuture<Deal> search = deal->future();
+    delete deal;
+    search.cancel();
+    unsetCursor();
+}
+
+// Deals a board off the UI thread.  A no-guess search stops as soon as the
+// future is cancelled, and then leaves it without a result.
+void MainWindow::generateGame(QPromise<Deal>& promise, const GameBoard& board, bool noGuess)
+{
+    if (noGuess)
+    {
+        NoGuessGenerator::Result result = NoGuessGenerator{}.generate(board, 0, [&promise]() { return promise.isCanceled(); });
+        if (result.canceled)
+        {
+            return;
+        }
+        if (result.state)
+        {
+            promise.addResult(Deal{std::move(*result.state), NoGuessGenerator::startCell()});
+            return;
+        }
+
+        qWarning("No board of %dx%d with %d mines could be cleared without guessing; dealing an ordinary one",
+                 board.rows(), board.cols(), board.mines());
+    }
+    promise.addResult(Deal{GameState{board}});
+}
+
+void MainWindow::prefetchNextGame()
+{
+    m_prefetchBoard = m_board;
+    m_prefetchNoGuess = m_noGuess;
+    m_prefetch = QtConcurrent::run(generateGame, m_board, m_noGuess);
+}
+
+void MainWindow::cancelPrefetch()
+{
+    if (m_prefetch.isValid())
+    {
+        m_prefetch.cancel();
+        m_prefetch = {};
+    }
+}
+
+QFuture<MainWindow::Deal> MainWindow::takeNextGame()
+{
+    if (m_prefetch.isValid()
+        && m_prefetchBoard == m_board
+        && m_prefetchNoGuess == m_noGuess
+        && !m_prefetch.isCanceled())
+    {
+        // Normally long since finished; if not, it's still no slower than starting over.
+        return std::exchange(m_prefetch, {});
+    }
+
+    cancelPrefetch();
+    return QtConcurrent::run(generateGame, m_board, m_noGuess);
+}
+
+void MainWindow::requestHint()
+{
+    const MineField* field = qobject_cast<MineField*>(centralWidget());
+    if (field == nullptr || !field->isEnabled())
+    {
+        return;
+    }
+
+    m_hintWanted = true;
+    startHint();
+}
+
+void MainWindow::startHint()
+{
+    cancelHint();
+
+    // The search works on its own copy of the position, so the player can
+    // keep playing; a move just cancels it and starts another.
+    const MineField* field = static_cast<MineField*>(centralWidget());
+    m_hintWatcher->setFuture(QtConcurrent::run([finder = m_hintFinder, state = field->state()](QPromise<HintFinder::Hint>& promise) {
+        const std::optional<HintFinder::Hint> hint = finder->find(state, [&promise]() { return promise.isCanceled(); });
+        if (hint)
+        {
+            promise.addResult(*hint);
+        }
+    }));
+
+    m_hintBusyTimer->start();
+}
+
+void MainWindow::cancelHint()
+{
+    // A cancelled search still finishes in the background, but hintFound()
+    // ignores it.
+    m_hintWatcher->future().cancel();
+
+    m_hintBusyTimer->stop();
+    if (centralWidget() != nullptr)
+    {
+        centralWidget()->unsetCursor();
+    }
+}
+
+void MainWindow::hintFound()
+{
+    // However the search ended, with a hint, with none to give or cancelled,
+    // nothing is waiting on it any more.
+    m_hintBusyTimer->stop();
+    m_hintWanted = false;
+    if (centralWidget() != nullptr)
+    {
+        centralWidget()->unsetCursor();
+    }
+
+    const QFuture<HintFinder::Hint> future = m_hintWatcher->future();
+    if (future.isCanceled() || future.resultCount() == 0)
+    {
+        return;
+    }
+
+    const HintFinder::Hint hint = future.result();
+    static_cast<MineField*>(centralWidget())->showHint(hint.cell, hint.safe);
 }
 
 int MainWindow::rows() const
@@ -224,10 +799,25 @@ int MainWindow::mines() const
 
 void MainWindow::win()
 {
+    m_clock->pause();
+    m_hintWanted = false;
+    cancelHint();
+    saveGame();
+    saveRecording();
+    recordGame(true);
+
+    const MineField* field = static_cast<MineField*>(centralWidget());
+    const int threeBV = field->state().threeBV();
+    // Guards against a division by zero, but no one clears a board in a millisecond.
+    const double seconds = std::max(m_clock->elapsedSeconds(), 0.001);
+
     int ret = QMessageBox::information(
         this,
         tr("You win!"),
-        tr("Nice work!  Would you like to try again?"),
+        tr("Nice work!  You cleared a board of 3BV %1 in %2 seconds, at %3 3BV/s.  Would you like to try again?")
+            .arg(threeBV)
+            .arg(seconds, 0, 'f', 3)
+            .arg(static_cast<double>(threeBV) / seconds, 0, 'f', 2),
         QMessageBox::Yes | QMessageBox::No,
         QMessageBox::Yes
     );
@@ -240,6 +830,32 @@ void MainWindow::win()
 
 void MainWindow::lose()
 {
+    m_clock->pause();
+    m_hintWanted = false;
+    cancelHint();
+    saveGame();
+    saveRecording();
+    recordGame(false);
+
+    if (m_endless)
+    {
+        const EndlessField* field = static_cast<EndlessField*>(centralWidget());
+
+        int ret = QMessageBox::critical(
+            this,
+            tr("You lost"),
+            tr("You cleared %n cell(s).  Would you like to try again?", nullptr, static_cast<int>(field->world().cleared())),
+            QMessageBox::Yes | QMessageBox::No,
+            QMessageBox::Yes
+        );
+
+        if (ret == QMessageBox::Yes)
+        {
+            initializeEndlessGame();
+        }
+        return;
+    }
+
     int ret = QMessageBox::critical(
         this,
         tr("You lost"),
@@ -256,5 +872,5 @@ void MainWindow::lose()
 
 void MainWindow::clockTicked(int elapsed)
 {
-    qInfo() << "Tick: " << elapsed;
+    m_time->setText(tr("%1:%2").arg(elapsed / 60).arg(elapsed % 60, 2, 10, QLatin1Char('0')));
 }
@@ -19,17 +19,33 @@
 #define MAINWINDOW_H
 
 #include "aboutdialog.h"
-#include "cell.h"
 #include "clock.h"
 #include "gameboard.h"
+#include "gamestate.h"
+#include "hint.h"
 #include "minefield.h"
+#include "recording.h"
+#include "savegame.h"
+#include "statsdialog.h"
+#include "statslog.h"
 
 #include <QAction>
 #include <QActionGroup>
+#include <QFuture>
+#include <QFutureWatcher>
 #include <QGridLayout>
+#include <QHideEvent>
+#include <QLabel>
+#include <QShowEvent>
+#include <QThreadPool>
 #include <QList>
 #include <QMainWindow>
 #include <QPoint>
+#include <QPromise>
+#include <QTimer>
+
+#include <memory>
+#include <optional>
 
 class MainWindow : public QMainWindow
 {
@@ -38,18 +54,53 @@ class MainWindow : public QMainWindow
 public:
     MainWindow(QWidget *parent = nullptr);
 
+protected:
+    void hideEvent(QHideEvent* event) override;
+    void showEvent(QShowEvent* event) override;
+
 private slots:
     void beginCustomGame(bool checked);
+    void setNoGuess(bool noGuess);
     void showAboutDialog();
+    void showStatsDialog();
     void clockTicked(int elapsed);
+    void requestHint();
+    void hintFound();
+    void saveGame();
+    void openReplay();
 
 private:
+    // A board dealt in the background.
+    struct Deal
+    {
+        GameState state;
+        int start{-1}; // on a no-guess board, the cell it can be cleared from
+    };
+
     void initializeActions();
     void initializeMenu();
-    void initializeGame(GameBoard board);
-    void initializeGrid();
+    void initializeGame(GameBoard board, std::optional<GameState> resumed = std::nullopt);
+    void initializeGrid(std::optional<GameState> resumed = std::nullopt);
+    void showField(GameState state, int start = -1);
+    void cancelDeal();
+    void initializeEndlessGame();
+    void startReplay(Recording recording, double speed);
+    void fitToField(int width, int height);
 
     void updateMenuCheckboxes();
+    void saveSettings();
+
+    bool resumeGame();
+    void saveRecording();
+    void recordGame(bool won);
+
+    static void generateGame(QPromise<Deal>& promise, const GameBoard& board, bool noGuess);
+    void prefetchNextGame();
+    void cancelPrefetch();
+    QFuture<Deal> takeNextGame();
+
+    void startHint();
+    void cancelHint();
 
     int rows() const;
     int cols() const;
@@ -59,16 +110,60 @@ private:
     void lose();
 
     GameBoard m_board;
-    QList<Cell*> m_cells;
+
+    // Whether to deal only boards that can be cleared without guessing.
+    bool m_noGuess;
+
+    // Whether the current game is on an endless board rather than m_board.
+    bool m_endless;
+
+    // Whether the current game is a recording being played back.
+    bool m_replaying;
+
+    // The next game for m_prefetchBoard, generated in the background so that
+    // starting it doesn't have to wait for mines to be laid.
+    QFuture<Deal> m_prefetch;
+    GameBoard m_prefetchBoard;
+    bool m_prefetchNoGuess;
+
+    // Watches a no-guess game that wasn't ready when it was wanted, with the
+    // window left empty until it is; null when nothing is being waited for.
+    QFutureWatcher<Deal>* m_deal;
+
+    // The hint being worked out in the background.  While the player wants
+    // a hint that hasn't been shown yet, every move restarts the search from
+    // the new position; the busy timer puts up a busy cursor if it takes
+    // longer than a frame.
+    std::shared_ptr<const HintFinder> m_hintFinder; // kept, with its caches, across moves and games
+    QFutureWatcher<HintFinder::Hint>* m_hintWatcher;
+    QTimer* m_hintBusyTimer;
+    bool m_hintWanted;
 
     QActionGroup* m_gameSizeGroup;
     QAction* m_smallGame;
     QAction* m_mediumGame;
     QAction* m_largeGame;
     QAction* m_customGame;
+    QAction* m_endlessGame;
+    QAction* m_noGuessGame;
+    QAction* m_hint;
+    QAction* m_replay;
+    QAction* m_statistics;
 
     AboutDialog* m_about;
+    StatsDialog* m_statsDialog;
     Clock* m_clock;
+    QLabel* m_time;  // the time played, in the status bar
+    QLabel* m_score; // likewise the cells cleared, shown only in endless games
+
+    // What the settings last written hold, so that starting another game
+    // of the same size writes nothing.
+    GameBoard m_savedBoard;
+    bool m_savedNoGuess;
+
+    // Writes settings and statistics one after another, off the UI thread.
+    QThreadPool m_background;
+    StatsLog m_stats;
 };
 
 #endif // MAINWINDOW_H
@@ -17,199 +17,418 @@
 
 #include "minefield.h"
 
-#include <QGridLayout>
+#include <QColor>
+#include <QRegion>
 #include <QSizePolicy>
 
 #include <algorithm>
-#include <random>
-#include <ranges>
-#include <vector>
+#include <utility>
 
 namespace {
 
 constexpr int kCellSize = 30;
 
-auto allCells(const GameBoard& board)
+} // namespace
+
+Q_LOGGING_CATEGORY(lcRender, "mines.render", QtWarningMsg)
+
+MineField::MineField(GameState state, QWidget *parent)
+    : QWidget{parent}
+    , m_state{std::move(state)}
+    , m_started{}
+    , m_gameOver{}
+    , m_leftPressedIndex{-1}
+    , m_rightPressedIndex{-1}
+    , m_middlePressedIndex{-1}
+    , m_chording{}
+    , m_cellSize{kCellSize}
+    , m_hintIndex{-1}
+    , m_hintSafe{}
+    , m_moves{}
 {
-    using namespace std::ranges::views;
+    const bool fresh = std::none_of(m_state.cells().begin(), m_state.cells().end(), [](GameState::CellBits cell) {
+        return (cell & (GameState::kRevealedBit | GameState::kFlaggedBit)) != 0;
+    });
+    if (fresh && m_state.seed() != 0)
+    {
+        m_recording.emplace(GameBoard{rows(), cols(), m_state.mineCount()}, m_state.seed());
+    }
 
-    int rows = board.rows();
-    int cols = board.cols();
-    int numCells = rows * cols;
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+    setMinimumSize(sizeHint());
 
-    auto toPoint = [cols](int n) {
-        int x = n % cols;
-        int y = n / cols;
-        return QPoint{x, y};
-    };
+    // paintEvent covers every exposed pixel, so Qt needn't erase the background first.
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
 
-    return iota(0, numCells) | transform(toPoint);
+QSize MineField::sizeHint() const
+{
+    return QSize{cols() * kCellSize, rows() * kCellSize};
 }
 
-auto neighborsOf(const GameBoard& board, QPoint point)
+void MineField::showHint(int index, bool safe)
 {
-    using namespace std::ranges::views;
+    clearHint();
 
-    static constexpr QPoint offsets[] {
-                                      {-1, -1}, {0, -1}, {1, -1},
-                                      {-1,  0},          {1,  0},
-                                      {-1,  1}, {0,  1}, {1,  1},
-                                      };
+    m_hintIndex = index;
+    m_hintSafe = safe;
+    updateCell(index);
+}
 
-    QRect bounds{0, 0, board.cols(), board.rows()};
+void MineField::clearHint()
+{
+    const int hint = std::exchange(m_hintIndex, -1);
+    if (hint >= 0)
+    {
+        updateCell(hint);
+    }
+}
 
-    auto applyOffset = [point](QPoint o) { return point + o; };
-    auto withinBounds = [bounds = std::move(bounds)](QPoint p) { return bounds.contains(p); };
+void MineField::mousePressEvent(QMouseEvent* event)
+{
+    int ix = indexAt(event->pos());
+    if (ix < 0)
+    {
+        event->ignore();
+        return;
+    }
 
-    return offsets
-           | transform(applyOffset)
-           | filter(withinBounds);
-}
+    beginAction();
 
+    if (event->button() == Qt::LeftButton)
+    {
+        m_leftPressedIndex = ix;
+        updateCell(ix);
+    }
+    else if (event->button() == Qt::RightButton)
+    {
+        m_rightPressedIndex = ix;
+    }
+    else if (event->button() == Qt::MiddleButton)
+    {
+        m_middlePressedIndex = ix;
+    }
+
+    if ((event->buttons() & (Qt::LeftButton | Qt::RightButton)) == (Qt::LeftButton | Qt::RightButton))
+    {
+        m_chording = true;
+    }
+
+    event->accept();
 }
 
-MineField::MineField(GameBoard board, QWidget *parent)
-    : QWidget{parent}
-    , m_board{board}
-    , m_cells{}
-    , m_started{}
+void MineField::mouseReleaseEvent(QMouseEvent* event)
 {
-    QGridLayout* grid = new QGridLayout;
-    grid->setHorizontalSpacing(0);
-    grid->setVerticalSpacing(0);
-    grid->setContentsMargins(0, 0, 0, 0);
-
-    QSizePolicy sizePolicy;
-    sizePolicy.setHorizontalPolicy(QSizePolicy::Expanding);
-    sizePolicy.setVerticalPolicy(QSizePolicy::Expanding);
-    sizePolicy.setWidthForHeight(true);
+    // As with a button, a click only counts if it is released over the cell where it began.
+    int ix = indexAt(event->pos());
 
-    m_cells.reserve(rows() * cols());
-    for (QPoint coord : allCells(m_board))
+    if (m_chording && (event->button() == Qt::LeftButton || event->button() == Qt::RightButton))
     {
-        Cell* cell = new Cell(coord, this);
-        cell->setSizePolicy(sizePolicy);
-        cell->setMinimumHeight(kCellSize);
-        cell->setMinimumWidth(kCellSize);
+        // Releasing either button of a two-button chord ends it; the other
+        // button's release then does nothing.
+        m_chording = false;
 
-        connect(cell, &Cell::revealed, this, &MineField::cellRevealed);
-        connect(this, &MineField::gameWon, cell, &Cell::gameEnded);
-        connect(this, &MineField::gameLost, cell, &Cell::gameEnded);
+        const int left = std::exchange(m_leftPressedIndex, -1);
+        const int right = std::exchange(m_rightPressedIndex, -1);
+        if (left >= 0)
+        {
+            updateCell(left);
+        }
+
+        if (ix >= 0 && (ix == left || ix == right))
+        {
+            play(Recording::Action::Chord, ix);
+        }
+    }
+    else if (event->button() == Qt::LeftButton)
+    {
+        int pressed = std::exchange(m_leftPressedIndex, -1);
+        if (pressed >= 0)
+        {
+            updateCell(pressed);
+        }
 
-        grid->addWidget(cell, coord.y(), coord.x());
-        m_cells << cell;
+        if (pressed >= 0 && pressed == ix)
+        {
+            play(Recording::Action::Reveal, ix);
+        }
+    }
+    else if (event->button() == Qt::RightButton)
+    {
+        int pressed = std::exchange(m_rightPressedIndex, -1);
+        if (pressed >= 0 && pressed == ix)
+        {
+            play(m_state.isFlagged(ix) ? Recording::Action::Unflag : Recording::Action::Flag, ix);
+        }
     }
+    else if (event->button() == Qt::MiddleButton)
+    {
+        int pressed = std::exchange(m_middlePressedIndex, -1);
+        if (pressed >= 0 && pressed == ix)
+        {
+            play(Recording::Action::Chord, ix);
+        }
+    }
+
+    event->accept();
+}
 
-    // Next, mark cells that are mines.
-    // Make a random list of cell indices, take as many non-corner cells as required,
-    // and mark them as mines.
+void MineField::paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this);
 
-    std::vector<int> indices(rows() * cols()); // I'd use a QList here but MSVC complains about implicit conversion between iterators and pointers
-    std::iota(indices.begin(), indices.end(), 0);
-    std::shuffle(indices.begin(), indices.end(), std::mt19937(std::random_device{}()));
+    ++m_renderStats.paintEvents;
 
-    auto toPoint = [cols = cols()](int n) { return QPoint{n % cols, n / cols}; };
-    auto nonCorner = [&](QPoint p) { return !isCorner(p); };
-    auto mineCells = indices
-                     | std::ranges::views::transform(toPoint)
-                     | std::ranges::views::filter(nonCorner)
-                     | std::ranges::views::take(m_board.mines());
+    m_tiles.prepare(QSize{m_cellSize, m_cellSize}, devicePixelRatioF(), font());
 
-    for (QPoint point : mineCells)
+    // Whatever the grid doesn't cover, when the widget isn't an exact multiple
+    // of the cell size, is left as plain background.
+    const QRect grid{0, 0, cols() * m_cellSize, rows() * m_cellSize};
+    const QRegion margin = QRegion(event->rect()) - grid;
+    for (const QRect& r : margin)
     {
-        Q_ASSERT(!isCorner(point));
-        cellAt(point)->setNumNeighboringMines(-1);
+        painter.fillRect(r, palette().window());
     }
 
-    // Finally, mark all non-mines with the count of surrounding mines.
-    for (QPoint coord : allCells(m_board))
+    // Only visit the cells that intersect the exposed area.
+    const QRect exposed = event->rect() & grid;
+    if (exposed.isEmpty())
     {
-        Cell* cell = cellAt(coord);
-        if (cell->isMine())
+        return;
+    }
+
+    const int left = columnAt(exposed.left());
+    const int right = columnAt(exposed.right());
+    const int top = rowAt(exposed.top());
+    const int bottom = rowAt(exposed.bottom());
+
+    for (int y = top; y <= bottom; ++y)
+    {
+        for (int x = left; x <= right; ++x)
         {
-            continue;
+            paintCell(painter, y * cols() + x);
         }
+    }
 
-        using namespace std::ranges::views;
-
-        auto ns = neighborsOf(m_board, coord)
-                  | transform([&](auto p) { return cellAt(p); })
-                  | filter([](auto c) { return c->isMine(); });
+    m_renderStats.cellsPainted += (right - left + 1) * (bottom - top + 1);
 
-        auto numNeighbors = std::ranges::distance(ns);
+    qCDebug(lcRender) << "cells changed:" << m_renderStats.cellsChanged
+                      << "update requests:" << m_renderStats.updateRequests
+                      << "paint events:" << m_renderStats.paintEvents
+                      << "cells painted:" << m_renderStats.cellsPainted;
+}
 
-        cell->setNumNeighboringMines(numNeighbors);
-    }
+void MineField::resizeEvent(QResizeEvent* event)
+{
+    m_cellSize = std::max(1, std::min(event->size().width() / cols(), event->size().height() / rows()));
 
-    setLayout(grid);
+    QWidget::resizeEvent(event);
 }
 
-void MineField::cellRevealed(const QPoint& coord)
+void MineField::revealCells(const std::vector<int>& cells)
 {
+    if (cells.empty())
+    {
+        return;
+    }
+
     if (!m_started)
     {
         m_started = true;
         emit gameStarted();
     }
 
-    Cell* cell = cellAt(coord);
-    if (cell->isMine())
+    const std::vector<int> revealed = m_state.revealCells(cells);
+    if (revealed.empty())
     {
-        lose();
         return;
     }
 
-    if (cell->getNumNeighboringMines() == 0)
+    clearHint();
+    updateCells(revealed);
+
+    emit cellsRevealed(QList<int>(revealed.begin(), revealed.end()));
+
+    const GameState::FrontierDelta& delta = m_state.frontierDelta();
+    if (!delta.added.empty() || !delta.removed.empty())
     {
-        for (const auto& neighbor : neighborsOf(m_board, coord))
-        {
-            cellAt(neighbor)->reveal();
-        }
+        emit frontierChanged(QList<int>(delta.added.begin(), delta.added.end()),
+                             QList<int>(delta.removed.begin(), delta.removed.end()));
+    }
 
+    if (std::any_of(revealed.begin(), revealed.end(), [this](int ix) { return m_state.isMine(ix); }))
+    {
+        lose();
         return;
     }
 
-    if (isBoardSolved())
+    if (m_state.isSolved())
     {
         win();
     }
 }
 
-bool MineField::isBoardSolved() const
+void MineField::chord(int index)
 {
-    return std::all_of(
-        std::begin(m_cells),
-        std::end(m_cells),
-        [](Cell* c) { return c->isRevealed() || c->isMine(); }
-    );
+    revealCells(m_state.chordCells(index));
 }
 
-bool MineField::isCorner(const QPoint& point) const
+void MineField::toggleFlag(int index)
 {
-    int xmin = 0;
-    int ymin = 0;
-    int xmax = cols() - 1;
-    int ymax = rows() - 1;
-    return (point.x() == xmin && point.y() == ymin)
-           || (point.x() == xmax && point.y() == ymin)
-           || (point.x() == xmin && point.y() == ymax)
-           || (point.x() == xmax && point.y() == ymax);
+    if (m_state.toggleFlag(index))
+    {
+        updateCell(index);
+        emit flagToggled(index);
+    }
+}
+
+void MineField::play(Recording::Action action, int index)
+{
+    // Recorded before it is made, so that a move that ends the game is in
+    // the recording by the time gameWon() or gameLost() goes out.  Moves
+    // that would change nothing aren't recorded or counted at all.
+    if (Recording::isLegal(m_state, action, index))
+    {
+        ++m_moves;
+
+        if (!m_moveClock.isValid())
+        {
+            m_moveClock.start();
+        }
+
+        if (m_recording)
+        {
+            m_recording->append(Recording::Move{action, index, m_moveClock.nsecsElapsed() / 1000});
+        }
+    }
+
+    switch (action)
+    {
+    case Recording::Action::Reveal:
+        revealCells({index});
+        break;
+    case Recording::Action::Flag:
+    case Recording::Action::Unflag:
+        toggleFlag(index);
+        break;
+    case Recording::Action::Chord:
+        chord(index);
+        break;
+    }
 }
 
 int MineField::rows() const
 {
-    return m_board.rows();
+    return m_state.rows();
 }
 
 int MineField::cols() const
 {
-    return m_board.cols();
+    return m_state.cols();
+}
+
+int MineField::columnAt(int x) const
+{
+    return std::clamp(x / m_cellSize, 0, cols() - 1);
+}
+
+int MineField::rowAt(int y) const
+{
+    return std::clamp(y / m_cellSize, 0, rows() - 1);
 }
 
-Cell* MineField::cellAt(const QPoint& coord)
+int MineField::indexAt(const QPoint& pos) const
 {
-    int ix = coord.y() * cols() + coord.x();
-    return m_cells[ix];
+    if (pos.x() < 0 || pos.y() < 0 || pos.x() >= cols() * m_cellSize || pos.y() >= rows() * m_cellSize)
+    {
+        return -1;
+    }
+
+    return rowAt(pos.y()) * cols() + columnAt(pos.x());
+}
+
+QRect MineField::cellRect(int index) const
+{
+    const QPoint coord = m_state.pointOf(index);
+    return QRect{coord.x() * m_cellSize, coord.y() * m_cellSize, m_cellSize, m_cellSize};
+}
+
+void MineField::beginAction()
+{
+    m_renderStats = {};
+}
+
+void MineField::updateCell(int index)
+{
+    ++m_renderStats.cellsChanged;
+    ++m_renderStats.updateRequests;
+    update(cellRect(index));
+}
+
+void MineField::updateCells(const std::vector<int>& cells)
+{
+    if (cells.empty())
+    {
+        return;
+    }
+
+    // One update for the bounding box of the whole batch.  Qt would merge
+    // per-cell updates into much the same region anyway, but only after
+    // bookkeeping for each of them.
+    int left = cols();
+    int right = -1;
+    int top = rows();
+    int bottom = -1;
+
+    for (int ix : cells)
+    {
+        const int x = ix % cols();
+        const int y = ix / cols();
+        left = std::min(left, x);
+        right = std::max(right, x);
+        top = std::min(top, y);
+        bottom = std::max(bottom, y);
+    }
+
+    m_renderStats.cellsChanged += static_cast<int>(cells.size());
+    ++m_renderStats.updateRequests;
+
+    update(QRect{left * m_cellSize, top * m_cellSize, (right - left + 1) * m_cellSize, (bottom - top + 1) * m_cellSize});
+}
+
+void MineField::paintCell(QPainter& painter, int index)
+{
+    TileAtlas::Tile tile;
+
+    if (m_state.isRevealed(index))
+    {
+        tile = m_state.isMine(index)
+            ? TileAtlas::ExplodedMine
+            : TileAtlas::numberTile(m_state.neighboringMines(index));
+    }
+    else if (m_gameOver && m_state.isMine(index))
+    {
+        tile = TileAtlas::Mine;
+    }
+    else if (index == m_leftPressedIndex)
+    {
+        tile = TileAtlas::Pressed;
+    }
+    else if (m_state.isFlagged(index))
+    {
+        tile = TileAtlas::Flag;
+    }
+    else
+    {
+        tile = TileAtlas::Raised;
+    }
+
+    painter.drawPixmap(cellRect(index).topLeft(), m_tiles.tile(tile));
+
+    if (index == m_hintIndex && !m_gameOver)
+    {
+        painter.fillRect(cellRect(index), m_hintSafe ? QColor{0, 192, 0, 112} : QColor{255, 160, 0, 112});
+    }
 }
 
 void MineField::win()
@@ -220,6 +439,8 @@ void MineField::win()
     }
 
     setEnabled(false);
+    m_gameOver = true;
+    update();
 
     emit gameWon();
 }
@@ -232,6 +453,8 @@ void MineField::lose()
     }
 
     setEnabled(false);
+    m_gameOver = true;
+    update();
 
     emit gameLost();
 }
@@ -18,43 +18,162 @@
 #ifndef MINEFIELD_H
 #define MINEFIELD_H
 
-#include "cell.h"
-#include "gameboard.h"
+#include "gamestate.h"
+#include "recording.h"
+#include "tileatlas.h"
 
+#include <QElapsedTimer>
 #include <QList>
+#include <QLoggingCategory>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QPainter>
 #include <QPoint>
+#include <QRect>
+#include <QResizeEvent>
+#include <QSize>
 #include <QWidget>
 
+#include <optional>
+
+Q_DECLARE_LOGGING_CATEGORY(lcRender)
+
 /**
- * @brief The MineField class implements the game's logic and core UI.
+ * @brief The MineField class presents a GameState and forwards the player's moves to it.
+ *
+ * The whole grid is a single widget; cells are painted and hit-tested here
+ * rather than being child widgets of their own.
  */
 class MineField : public QWidget
 {
     Q_OBJECT
 
-    GameBoard m_board;
-    QList<Cell*> m_cells;
+public:
+    /**
+     * @brief Counts of the rendering work caused by the most recent player action.
+     */
+    struct RenderStats
+    {
+        int cellsChanged{};   // cells whose appearance the action changed
+        int updateRequests{}; // calls to QWidget::update()
+        int paintEvents{};
+        int cellsPainted{};
+    };
+
+private:
+    GameState m_state;
     bool m_started;
+    bool m_gameOver;
+    int m_leftPressedIndex;   // the cell where the left button went down, or -1
+    int m_rightPressedIndex;  // the cell where the right button went down, or -1
+    int m_middlePressedIndex; // the cell where the middle button went down, or -1
+    bool m_chording;          // both left and right went down; the first release chords
+    int m_cellSize;
+    int m_hintIndex;          // the cell to highlight as a hint, or -1
+    bool m_hintSafe;          // whether that cell is proven safe, or only the best guess
+    TileAtlas m_tiles;
+    RenderStats m_renderStats;
+    std::optional<Recording> m_recording; // the player's moves, if the game began here
+    QElapsedTimer m_moveClock;            // started by the first move
+    int m_moves;                          // the player's moves that changed something
 
 public:
-    explicit MineField(GameBoard board, QWidget *parent = nullptr);
+    explicit MineField(GameState state, QWidget *parent = nullptr);
+
+    const GameState& state() const { return m_state; }
+
+    int remainingSafeCells() const { return m_state.remainingSafeCells(); }
+
+    /**
+     * @brief Whether the game has had a cell revealed and is not yet won or lost.
+     */
+    bool isInProgress() const
+    {
+        return !m_gameOver && m_state.remainingSafeCells() < m_state.size() - m_state.mineCount();
+    }
+
+    const RenderStats& renderStats() const { return m_renderStats; }
+
+    /**
+     * @brief Every move the player has made here, or nothing if the game
+     *        was already under way when the field was created, as a resumed
+     *        one is, or has no seed to replay it from.
+     */
+    const std::optional<Recording>& recording() const { return m_recording; }
+
+    /**
+     * @brief How many of the player's moves here changed something.
+     */
+    int moves() const { return m_moves; }
+
+    QSize sizeHint() const override;
+
+    /**
+     * @brief Reveals the given cells, and any openings they belong to, as a
+     *        single move: one update of the game state, one repaint and one
+     *        check for a win or loss.
+     */
+    void revealCells(const std::vector<int>& cells);
+
+    /**
+     * @brief Chords on a revealed number: if as many of its neighbors are
+     *        flagged as it has neighboring mines, reveals all the others.
+     */
+    void chord(int index);
+
+    void toggleFlag(int index);
+
+    /**
+     * @brief Highlights a cell as a hint, replacing any earlier hint.  The
+     *        highlight is cleared by the next move, or by clearHint().
+     */
+    void showHint(int index, bool safe);
+    void clearHint();
 
 signals:
     void gameStarted();
+
+    /**
+     * @brief Emitted once per move with every cell that the move revealed;
+     *        the size of the opening is cells.size().
+     */
+    void cellsRevealed(const QList<int>& cells);
+
+    /**
+     * @brief Emitted after any move that changed the frontier, with the cells
+     *        that joined and left it; see GameState::frontier().
+     */
+    void frontierChanged(const QList<int>& added, const QList<int>& removed);
+
+    /**
+     * @brief Emitted when a cell is flagged or unflagged.
+     */
+    void flagToggled(int index);
+
     void gameWon();
     void gameLost();
 
-private slots:
-    void cellRevealed(const QPoint& coord);
+protected:
+    void mousePressEvent(QMouseEvent* event) override;
+    void mouseReleaseEvent(QMouseEvent* event) override;
+    void paintEvent(QPaintEvent* event) override;
+    void resizeEvent(QResizeEvent* event) override;
 
 private:
-    bool isBoardSolved() const;
-    bool isCorner(const QPoint& point) const;
+    void play(Recording::Action action, int index);
 
     int rows() const;
     int cols() const;
 
-    Cell* cellAt(const QPoint& coord);
+    int columnAt(int x) const;
+    int rowAt(int y) const;
+    int indexAt(const QPoint& pos) const;
+    QRect cellRect(int index) const;
+    void beginAction();
+    void updateCell(int index);
+    void updateCells(const std::vector<int>& cells);
+
+    void paintCell(QPainter& painter, int index);
 
     void win();
     void lose();
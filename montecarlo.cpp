@@ -0,0 +1,580 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "montecarlo.h"
+
+#include "rng.h"
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+
+namespace {
+
+// Two-sided 95% quantile of the normal distribution.
+constexpr double kZ95 = 1.96;
+
+// Samples averaged into each batch, and batches needed before the spread
+// between them is trusted to judge convergence.
+constexpr int kSamplesPerBatch = 64;
+constexpr qint64 kMinBatches = 16;
+
+// How strongly the sampling chains are held to the constraints: a move that
+// puts them one mine further from satisfied is accepted at most
+// exp(-kSamplingBeta) of the time.  Lower values let the chains roam more
+// freely, at the cost of more samples thrown away for being inconsistent.
+constexpr double kSamplingBeta = 2.0;
+
+// The longest a cancellation goes unnoticed while no batch is coming in, as
+// when the chains are still annealing.
+constexpr std::chrono::milliseconds kCancelPollInterval{10};
+
+// The sampler's view of the problem: the frontier cells and constraints over
+// them, by local index.  Interior cells are interchangeable, so only how many
+// mines they hold matters, and they are kept as a count.
+struct Model
+{
+    std::vector<int> cells;                      // global index of each frontier cell
+    std::vector<int> need;                       // mines required by each constraint
+    std::vector<std::vector<int>> constraintsOf; // constraints covering each cell
+    std::vector<std::vector<int>> partners;      // other cells sharing a constraint with each
+    int interiorCells{};
+    int mines{};                                 // mines to place, frontier and interior
+};
+
+Model buildModel(const ConstraintProblem& problem)
+{
+    Model model;
+
+    for (const auto& component : problem.components)
+    {
+        const int base = static_cast<int>(model.cells.size());
+        model.cells.insert(model.cells.end(), component.cells.begin(), component.cells.end());
+        model.constraintsOf.resize(model.cells.size());
+        model.partners.resize(model.cells.size());
+
+        for (const auto& constraint : component.constraints)
+        {
+            const int c = static_cast<int>(model.need.size());
+            model.need.push_back(constraint.mines);
+            for (int position : constraint.cells)
+            {
+                model.constraintsOf[base + position].push_back(c);
+                for (int other : constraint.cells)
+                {
+                    if (other != position)
+                    {
+                        model.partners[base + position].push_back(base + other);
+                    }
+                }
+            }
+        }
+    }
+
+    for (auto& partners : model.partners)
+    {
+        std::sort(partners.begin(), partners.end());
+        partners.erase(std::unique(partners.begin(), partners.end()), partners.end());
+    }
+
+    model.interiorCells = static_cast<int>(problem.interior.size());
+    model.mines = problem.minesLeft;
+
+    return model;
+}
+
+// Running sums of batch averages, merged from every chain.
+struct Tally
+{
+    std::vector<double> sum;
+    std::vector<double> sumSquares;
+    double interiorSum{};
+    double interiorSumSquares{};
+    qint64 batches{};
+    qint64 samples{};
+};
+
+double halfWidthOf(double sum, double sumSquares, qint64 n)
+{
+    if (n < 2)
+    {
+        return 1.0;
+    }
+    const double mean = sum / n;
+    const double variance = std::max(0.0, (sumSquares - n * mean * mean) / (n - 1));
+    return kZ95 * std::sqrt(variance / n);
+}
+
+// State shared between the chains and the thread waiting on them.
+struct Shared
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::atomic<bool> stop{false};
+    Tally tally;
+    int running{};
+};
+
+// One Markov chain over placements of the frontier's mines, with the rest in
+// the interior.  A placement with k frontier mines stands for C(interior
+// cells, mines - k) placements of the whole board, and is weighed by that,
+// times exp(-beta * V), where V is the total violation: the sum over
+// constraints of how far each is from its number.
+//
+// Two kinds of move are proposed, each as likely as its reverse:
+//
+//   - a flip turns one frontier cell into a mine or back, taking the mine
+//     from the interior or returning it there;
+//   - a swap exchanges a frontier cell with a neighbor sharing one of its
+//     constraints, which moves a mine locally without changing the count.
+//
+// A flip always breaks some constraint, so a chain that refused every such
+// move could never change how many mines the frontier holds; allowing them
+// at a cost keeps every placement reachable.  Every placement with V = 0 has
+// its true weight, so the consistent samples follow the exact distribution.
+class Chain
+{
+public:
+    Chain(const Model& model, Rng rng)
+        : m_model{model}
+        , m_rng{rng}
+        , m_mine(model.cells.size(), 0)
+        , m_count(model.need.size(), 0)
+    {
+    }
+
+    void run(Shared& shared);
+
+private:
+    void placeRandomly();
+    bool anneal(const std::atomic<bool>& stop);
+    void step(double beta);
+    void flip(int cell, double beta);
+    void swap(int cell, double beta);
+    void toggle(int cell);
+    int violationAround(int cell) const;
+
+    const Model& m_model;
+    Rng m_rng;
+
+    std::vector<std::uint8_t> m_mine; // whether each frontier cell holds a mine
+    std::vector<int> m_count;         // mines currently under each constraint
+    int m_frontierMines{};
+    int m_violation{};
+};
+
+// Places the mines uniformly over every unknown cell, frontier and interior.
+void Chain::placeRandomly()
+{
+    const int frontier = static_cast<int>(m_model.cells.size());
+
+    std::fill(m_count.begin(), m_count.end(), 0);
+    m_frontierMines = 0;
+
+    // Selection sampling: each cell in turn is a mine with probability
+    // (mines still to place) / (cells still to consider).
+    int remaining = frontier + m_model.interiorCells;
+    int toPlace = m_model.mines;
+    for (int cell = 0; cell < frontier; ++cell, --remaining)
+    {
+        m_mine[cell] = m_rng.bounded(static_cast<std::uint32_t>(remaining))
+                       < static_cast<std::uint32_t>(toPlace);
+        if (m_mine[cell])
+        {
+            --toPlace;
+            ++m_frontierMines;
+            for (int c : m_model.constraintsOf[cell])
+            {
+                ++m_count[c];
+            }
+        }
+    }
+
+    m_violation = 0;
+    for (size_t c = 0; c < m_count.size(); ++c)
+    {
+        m_violation += std::abs(m_count[c] - m_model.need[c]);
+    }
+}
+
+int Chain::violationAround(int cell) const
+{
+    int violation = 0;
+    for (int c : m_model.constraintsOf[cell])
+    {
+        violation += std::abs(m_count[c] - m_model.need[c]);
+    }
+    return violation;
+}
+
+void Chain::toggle(int cell)
+{
+    const int delta = m_mine[cell] ? -1 : 1;
+    m_mine[cell] ^= 1;
+    m_frontierMines += delta;
+    for (int c : m_model.constraintsOf[cell])
+    {
+        m_count[c] += delta;
+    }
+}
+
+void Chain::flip(int cell, double beta)
+{
+    // Interior mines before and after the flip, and the ratio of the number
+    // of ways to place them, C(interior, after) / C(interior, before).
+    const int interior = m_model.interiorCells;
+    const int before = m_model.mines - m_frontierMines;
+    const int after = m_mine[cell] ? before + 1 : before - 1;
+    if (after < 0 || after > interior)
+    {
+        return;
+    }
+    const double ways = after > before
+        ? static_cast<double>(interior - before) / after
+        : static_cast<double>(before) / (interior - after);
+
+    const int violationBefore = violationAround(cell);
+    toggle(cell);
+    const int delta = violationAround(cell) - violationBefore;
+
+    if (m_rng.uniform() < ways * std::exp(-beta * delta))
+    {
+        m_violation += delta;
+    }
+    else
+    {
+        toggle(cell);
+    }
+}
+
+void Chain::swap(int cell, double beta)
+{
+    const std::vector<int>& partners = m_model.partners[cell];
+    if (partners.empty())
+    {
+        return;
+    }
+
+    const int other = partners[m_rng.bounded(static_cast<std::uint32_t>(partners.size()))];
+    if (m_mine[cell] == m_mine[other])
+    {
+        return;
+    }
+
+    // A constraint covering both cells is counted twice on each side, but
+    // its count doesn't change, so the difference is still right.
+    const int before = violationAround(cell) + violationAround(other);
+    toggle(cell);
+    toggle(other);
+    const int delta = violationAround(cell) + violationAround(other) - before;
+
+    if (delta <= 0 || m_rng.uniform() < std::exp(-beta * delta))
+    {
+        m_violation += delta;
+    }
+    else
+    {
+        toggle(cell);
+        toggle(other);
+    }
+}
+
+void Chain::step(double beta)
+{
+    const int cell = static_cast<int>(m_rng.bounded(static_cast<std::uint32_t>(m_model.cells.size())));
+    if (m_rng.bounded(2) == 0)
+    {
+        flip(cell, beta);
+    }
+    else
+    {
+        swap(cell, beta);
+    }
+}
+
+// Searches for a placement satisfying every constraint by simulated
+// annealing, restarting from scratch if it stalls.
+bool Chain::anneal(const std::atomic<bool>& stop)
+{
+    const qint64 frontier = static_cast<qint64>(m_model.cells.size());
+
+    while (!stop.load(std::memory_order_relaxed))
+    {
+        placeRandomly();
+        if (frontier == 0)
+        {
+            return true;
+        }
+
+        double beta = 0.5;
+        for (int round = 0; m_violation > 0 && round < 500; ++round)
+        {
+            if (stop.load(std::memory_order_relaxed))
+            {
+                return false;
+            }
+            for (qint64 i = 0; i < frontier && m_violation > 0; ++i)
+            {
+                step(beta);
+            }
+            beta = std::min(beta * 1.05, 8.0);
+        }
+
+        if (m_violation == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Chain::run(Shared& shared)
+{
+    auto finish = [&shared] {
+        std::lock_guard lock{shared.mutex};
+        --shared.running;
+        shared.changed.notify_all();
+    };
+
+    if (!anneal(shared.stop))
+    {
+        finish();
+        return;
+    }
+
+    // Consecutive samples are far enough apart that every frontier cell has
+    // had a chance to change.
+    const int frontier = static_cast<int>(m_model.cells.size());
+    const int stepsPerSample = frontier == 0 ? 0 : std::max(frontier, 16);
+    const double interiorCells = m_model.interiorCells;
+
+    std::vector<int> hits(frontier);
+    for (;;)
+    {
+        std::fill(hits.begin(), hits.end(), 0);
+        qint64 interiorMines = 0;
+
+        // Samples are taken at fixed intervals and kept only if consistent.
+        // Stopping at the first consistent placement after each interval
+        // instead would favour those the chain happens to reach quickly.
+        for (int sample = 0; sample < kSamplesPerBatch;)
+        {
+            if (shared.stop.load(std::memory_order_relaxed))
+            {
+                finish();
+                return;
+            }
+
+            for (int i = 0; i < stepsPerSample; ++i)
+            {
+                step(kSamplingBeta);
+            }
+            if (m_violation != 0)
+            {
+                continue;
+            }
+
+            for (int cell = 0; cell < frontier; ++cell)
+            {
+                hits[cell] += m_mine[cell];
+            }
+            interiorMines += m_model.mines - m_frontierMines;
+            ++sample;
+        }
+
+        std::lock_guard lock{shared.mutex};
+        Tally& tally = shared.tally;
+        for (int cell = 0; cell < frontier; ++cell)
+        {
+            const double mean = static_cast<double>(hits[cell]) / kSamplesPerBatch;
+            tally.sum[cell] += mean;
+            tally.sumSquares[cell] += mean * mean;
+        }
+        if (interiorCells > 0)
+        {
+            const double mean = interiorMines / (interiorCells * kSamplesPerBatch);
+            tally.interiorSum += mean;
+            tally.interiorSumSquares += mean * mean;
+        }
+        ++tally.batches;
+        tally.samples += kSamplesPerBatch;
+        shared.changed.notify_all();
+    }
+}
+
+// The widest interval among frontier cells and the interior as a whole.
+// Interior cells are interchangeable, so their shared estimate is used
+// rather than each one's own.
+double widestInterval(const Tally& tally, int frontierCells, bool hasInterior)
+{
+    double widest = 0.0;
+    for (int i = 0; i < frontierCells; ++i)
+    {
+        widest = std::max(widest, halfWidthOf(tally.sum[i], tally.sumSquares[i], tally.batches));
+    }
+    if (hasInterior)
+    {
+        widest = std::max(widest, halfWidthOf(tally.interiorSum, tally.interiorSumSquares, tally.batches));
+    }
+    return widest;
+}
+
+} // namespace
+
+MonteCarloEstimator::MonteCarloEstimator()
+    : m_budget{}
+{
+}
+
+MonteCarloEstimator::MonteCarloEstimator(const Budget& budget)
+    : m_budget{budget}
+{
+}
+
+MonteCarloEstimator::Result MonteCarloEstimator::estimate(const GameState& state, const Solver* solver, const std::function<bool()>& isCanceled) const
+{
+    return estimate(state, ConstraintProblem::fromState(state, solver), isCanceled);
+}
+
+MonteCarloEstimator::Result MonteCarloEstimator::estimate(const GameState& state, const ConstraintProblem& problem, const std::function<bool()>& isCanceled) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Result result;
+    result.mineProbability.assign(state.size(), 0.0);
+    result.halfWidth.assign(state.size(), 0.0);
+    for (int ix : problem.knownMines)
+    {
+        result.mineProbability[ix] = 1.0;
+    }
+
+    const Model model = buildModel(problem);
+    const int frontier = static_cast<int>(model.cells.size());
+
+    if (model.mines < 0 || model.mines > frontier + model.interiorCells)
+    {
+        result.elapsedNs = timer.nsecsElapsed();
+        return result;
+    }
+
+    const int threads = m_budget.threads > 0 ? m_budget.threads : std::max(1, QThread::idealThreadCount());
+    result.threads = threads;
+
+    Shared shared;
+    shared.tally.sum.assign(frontier, 0.0);
+    shared.tally.sumSquares.assign(frontier, 0.0);
+    shared.running = threads;
+
+    // Each chain draws from its own stretch of one random sequence, 2^128
+    // numbers apart from the next, so that no two chains ever overlap.
+    std::vector<Chain> chains;
+    chains.reserve(threads);
+    Rng rng{m_budget.seed != 0 ? m_budget.seed : Rng::randomSeed()};
+    for (int t = 0; t < threads; ++t)
+    {
+        chains.emplace_back(model, rng);
+        rng.jump();
+    }
+
+    // A pool of our own, so that every chain starts at once however busy the
+    // global pool is.
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+
+    std::vector<QFuture<void>> futures;
+    futures.reserve(threads);
+    for (Chain& chain : chains)
+    {
+        futures.push_back(QtConcurrent::run(&pool, [&chain, &shared] { chain.run(shared); }));
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_budget.timeMs);
+    {
+        std::unique_lock lock{shared.mutex};
+        for (;;)
+        {
+            const Tally& tally = shared.tally;
+            if (tally.batches >= kMinBatches
+                && widestInterval(tally, frontier, model.interiorCells > 0) <= m_budget.maxHalfWidth)
+            {
+                result.converged = true;
+                break;
+            }
+            if (isCanceled && isCanceled())
+            {
+                result.canceled = true;
+                break;
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            if (shared.running == 0 || now >= deadline)
+            {
+                break;
+            }
+            shared.changed.wait_until(lock, isCanceled ? std::min(deadline, now + kCancelPollInterval) : deadline);
+        }
+        shared.stop = true;
+    }
+
+    for (QFuture<void>& future : futures)
+    {
+        future.waitForFinished();
+    }
+
+    const Tally& tally = shared.tally;
+    result.batches = tally.batches;
+    result.samples = tally.samples;
+    result.consistent = !result.canceled && tally.batches > 0;
+
+    if (result.consistent)
+    {
+        for (int i = 0; i < frontier; ++i)
+        {
+            result.mineProbability[model.cells[i]] = tally.sum[i] / tally.batches;
+            result.halfWidth[model.cells[i]] = halfWidthOf(tally.sum[i], tally.sumSquares[i], tally.batches);
+        }
+
+        if (model.interiorCells > 0)
+        {
+            result.interiorProbability = tally.interiorSum / tally.batches;
+            result.interiorHalfWidth = halfWidthOf(tally.interiorSum, tally.interiorSumSquares, tally.batches);
+            for (int ix : problem.interior)
+            {
+                result.mineProbability[ix] = result.interiorProbability;
+                result.halfWidth[ix] = result.interiorHalfWidth;
+            }
+        }
+    }
+    else
+    {
+        result.converged = false;
+    }
+
+    result.elapsedNs = timer.nsecsElapsed();
+    return result;
+}
@@ -0,0 +1,111 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef MONTECARLO_H
+#define MONTECARLO_H
+
+#include "constraintproblem.h"
+#include "gamestate.h"
+#include "solver.h"
+
+#include <QtGlobal>
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Estimates the probability that each unrevealed cell is a mine by
+ *        sampling configurations consistent with everything visible.
+ *
+ * For frontiers too large for ProbabilityEngine to enumerate.  Each thread
+ * runs its own Markov chain with its own random stream: it first anneals a
+ * random placement of the remaining mines until every revealed number is
+ * satisfied, then keeps making local moves, swapping a mine with a
+ * neighboring empty cell or trading one with the interior, and counts the
+ * placements it passes through that satisfy every number.
+ *
+ * Confidence intervals come from batch means: each chain's samples are
+ * grouped into batches, and the spread of the batch averages across all
+ * chains bounds the error of the overall average.
+ */
+class MonteCarloEstimator
+{
+public:
+    struct Budget
+    {
+        qint64 timeMs{250};        // stop after this long, converged or not
+        double maxHalfWidth{0.01}; // or once every 95% interval is at least this narrow
+        int threads{0};            // 0 for one per core
+        std::uint64_t seed{0};     // 0 for a random seed
+    };
+
+    struct Result
+    {
+        /**
+         * @brief False if no chain found a configuration consistent with the
+         *        revealed numbers in time; there are then no estimates.
+         */
+        bool consistent{};
+
+        /**
+         * @brief True if every interval met the requested half-width.
+         */
+        bool converged{};
+
+        /**
+         * @brief True if the estimate was cancelled; there are then no estimates.
+         */
+        bool canceled{};
+
+        /**
+         * @brief The estimated probability that each cell is a mine, and the
+         *        half-width of its 95% confidence interval.  Revealed and
+         *        solver-proven cells are exact, with a half-width of 0.
+         */
+        std::vector<double> mineProbability;
+        std::vector<double> halfWidth;
+
+        double interiorProbability{};
+        double interiorHalfWidth{};
+
+        qint64 samples{};
+        qint64 batches{};
+        int threads{};
+        qint64 elapsedNs{};
+    };
+
+    /**
+     * @brief Creates an estimator with the default budget.
+     */
+    MonteCarloEstimator();
+    explicit MonteCarloEstimator(const Budget& budget);
+
+    /**
+     * @param isCanceled polled as each batch of samples comes in, and at
+     *        least every few milliseconds before the first; once it returns
+     *        true, the chains are stopped and the result is marked as
+     *        cancelled.
+     */
+    Result estimate(const GameState& state, const Solver* solver = nullptr, const std::function<bool()>& isCanceled = {}) const;
+    Result estimate(const GameState& state, const ConstraintProblem& problem, const std::function<bool()>& isCanceled = {}) const;
+
+private:
+    Budget m_budget;
+};
+
+#endif // MONTECARLO_H
@@ -0,0 +1,136 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "neighborcount.h"
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// MINES_FORCE_SCALAR leaves out the vector paths whatever the target, so that
+// the tests can check the scalar one on hardware that has the others.
+#if defined(MINES_FORCE_SCALAR)
+#elif defined(__AVX2__)
+#define MINES_HAVE_AVX2 1
+#define MINES_HAVE_SSE2 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MINES_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// out[i] = a[i] + b[i] + c[i] - d[i]; pass nullptr for d to skip the subtraction.
+// Sums never exceed 9, so byte-wise arithmetic cannot overflow.
+void sum3(const std::uint8_t* a, const std::uint8_t* b, const std::uint8_t* c, const std::uint8_t* d, std::uint8_t* out, int n)
+{
+    int i = 0;
+
+#if defined(MINES_HAVE_AVX2)
+    for (; i + 32 <= n; i += 32)
+    {
+        __m256i sum = _mm256_add_epi8(
+            _mm256_add_epi8(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i))),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + i)));
+
+        if (d != nullptr)
+        {
+            sum = _mm256_sub_epi8(sum, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(d + i)));
+        }
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), sum);
+    }
+#endif
+
+#if defined(MINES_HAVE_SSE2)
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i sum = _mm_add_epi8(
+            _mm_add_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(c + i)));
+
+        if (d != nullptr)
+        {
+            sum = _mm_sub_epi8(sum, _mm_loadu_si128(reinterpret_cast<const __m128i*>(d + i)));
+        }
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), sum);
+    }
+#endif
+
+    for (; i < n; ++i)
+    {
+        int sum = a[i] + b[i] + c[i] - (d != nullptr ? d[i] : 0);
+        out[i] = static_cast<std::uint8_t>(sum);
+    }
+}
+
+// out[x] = row[x - 1] + row[x] + row[x + 1], treating cells beyond either end as empty.
+void horizontalSum(const std::uint8_t* row, std::uint8_t* out, int cols)
+{
+    if (cols == 1)
+    {
+        out[0] = row[0];
+        return;
+    }
+
+    out[0] = row[0] + row[1];
+    sum3(row, row + 1, row + 2, nullptr, out + 1, cols - 2);
+    out[cols - 1] = row[cols - 2] + row[cols - 1];
+}
+
+} // namespace
+
+void countNeighboringMines(const std::uint8_t* mines, std::uint8_t* counts, int rows, int cols)
+{
+    if (rows <= 0 || cols <= 0)
+    {
+        return;
+    }
+
+    // Horizontal sums for the rows above, at, and below the current one, plus
+    // a row of zeros to stand in for the rows beyond the top and bottom edges.
+    std::vector<std::uint8_t> buffer(4 * static_cast<size_t>(cols), 0);
+    const std::uint8_t* zeros = buffer.data();
+    std::uint8_t* above = buffer.data() + cols;
+    std::uint8_t* current = above + cols;
+    std::uint8_t* below = current + cols;
+
+    horizontalSum(mines, current, cols);
+
+    for (int y = 0; y < rows; ++y)
+    {
+        const std::uint8_t* row = mines + static_cast<size_t>(y) * cols;
+        const bool hasAbove = y > 0;
+        const bool hasBelow = y + 1 < rows;
+
+        if (hasBelow)
+        {
+            horizontalSum(row + cols, below, cols);
+        }
+
+        sum3(hasAbove ? above : zeros, current, hasBelow ? below : zeros, row, counts + static_cast<size_t>(y) * cols, cols);
+
+        std::swap(above, current);
+        std::swap(current, below);
+    }
+}
@@ -0,0 +1,37 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef NEIGHBORCOUNT_H
+#define NEIGHBORCOUNT_H
+
+#include <cstdint>
+
+/**
+ * @brief Counts, for every cell of a rows x cols grid, how many of its eight
+ *        neighbors are mines.
+ *
+ * `mines` is a row-major plane of rows * cols bytes, each 1 for a mine and 0
+ * otherwise; `counts` receives rows * cols bytes.  The two must not overlap.
+ *
+ * The count is computed as a 3x3 box sum, done as a horizontal pass over each
+ * row followed by a vertical pass over each triple of rows, minus the center
+ * cell.  Both passes are plain byte additions, which are done sixteen or
+ * thirty-two at a time when SSE2 or AVX2 is available at compile time.
+ */
+void countNeighboringMines(const std::uint8_t* mines, std::uint8_t* counts, int rows, int cols);
+
+#endif // NEIGHBORCOUNT_H
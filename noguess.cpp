@@ -0,0 +1,143 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "noguess.h"
+
+#include "rng.h"
+#include "solver.h"
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+NoGuessGenerator::NoGuessGenerator(int threads, qint64 timeMs)
+    : m_threads{threads}
+    , m_timeMs{timeMs}
+{
+}
+
+int NoGuessGenerator::startCell()
+{
+    return 0;
+}
+
+bool NoGuessGenerator::isSolvableFrom(GameState state, int start)
+{
+    if (state.isMine(start))
+    {
+        return false;
+    }
+
+    Solver solver{state};
+    solver.update(state.revealArea(start));
+
+    while (!state.isSolved())
+    {
+        const std::vector<int> safe = solver.safeCells();
+        if (safe.empty())
+        {
+            return false;
+        }
+
+        solver.update(state.revealCells(safe));
+    }
+    return true;
+}
+
+NoGuessGenerator::Result NoGuessGenerator::generate(const GameBoard& board, std::uint64_t seed, const std::function<bool()>& isCanceled) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const int threads = m_threads > 0 ? m_threads : std::max(1, QThread::idealThreadCount());
+    const int start = startCell();
+
+    std::atomic<bool> done{false};
+    std::atomic<bool> canceled{false};
+    std::atomic<std::uint64_t> found{0};
+    std::atomic<qint64> attempts{0};
+
+    // Every worker keeps drawing candidates until one of them succeeds, time
+    // runs out or the search is cancelled, so a thread that happens to check
+    // a few slow boards holds nobody up: the others simply check more.
+    auto search = [&](Rng rng) {
+        while (!done.load(std::memory_order_relaxed) && !timer.hasExpired(m_timeMs))
+        {
+            if (isCanceled && isCanceled())
+            {
+                canceled = true;
+                done = true;
+                return;
+            }
+
+            // A seed of 0 marks a game whose mines were given explicitly.
+            const std::uint64_t candidate = rng();
+            if (candidate == 0)
+            {
+                continue;
+            }
+
+            attempts.fetch_add(1, std::memory_order_relaxed);
+            if (isSolvableFrom(GameState{board, candidate}, start))
+            {
+                bool expected = false;
+                if (done.compare_exchange_strong(expected, true))
+                {
+                    found = candidate;
+                }
+                return;
+            }
+        }
+    };
+
+    // A pool of our own, so that every worker starts at once however busy
+    // the global pool is; generation is itself often run on the global pool.
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+
+    // Each worker draws from its own stretch of one random sequence, 2^128
+    // numbers apart from the next, so that no two check the same board.
+    Rng rng{seed != 0 ? seed : Rng::randomSeed()};
+    std::vector<QFuture<void>> futures;
+    futures.reserve(threads);
+    for (int t = 0; t < threads; ++t)
+    {
+        futures.push_back(QtConcurrent::run(&pool, search, rng));
+        rng.jump();
+    }
+
+    for (QFuture<void>& future : futures)
+    {
+        future.waitForFinished();
+    }
+
+    Result result;
+    result.canceled = canceled && found == 0;
+    if (found != 0)
+    {
+        result.state.emplace(board, found.load());
+    }
+    result.attempts = attempts;
+    result.elapsedNs = timer.nsecsElapsed();
+    return result;
+}
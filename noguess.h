@@ -0,0 +1,95 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef NOGUESS_H
+#define NOGUESS_H
+
+#include "gameboard.h"
+#include "gamestate.h"
+
+#include <QtGlobal>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+
+/**
+ * @brief Generates boards that can be cleared without guessing, starting
+ *        from the top-left corner.
+ *
+ * Candidates are ordinary seeded boards, each checked by playing it out with
+ * a Solver: reveal the start, then everything the solver proves safe, until
+ * either the board is cleared or nothing more can be proven.  Several
+ * threads generate and check candidates at once, each drawing seeds from its
+ * own random stream; the first to find a solvable board stops the rest, as
+ * does a cancellation.
+ *
+ * Because the result is identified by its seed, it can be recreated exactly
+ * with GameState(board, seed).
+ */
+class NoGuessGenerator
+{
+public:
+    struct Result
+    {
+        /**
+         * @brief The board found, or nothing if none was found in time.
+         */
+        std::optional<GameState> state;
+
+        /**
+         * @brief True if the search was cancelled before it found a board.
+         */
+        bool canceled{};
+        qint64 attempts{};
+        qint64 elapsedNs{};
+    };
+
+    /**
+     * @param threads how many candidates to check at once; 0 for one per core.
+     * @param timeMs how long to search before giving up.  Dense boards may
+     *        have no solvable layout at all.
+     */
+    explicit NoGuessGenerator(int threads = 0, qint64 timeMs = 5000);
+
+    /**
+     * @brief Searches for a board that can be cleared without guessing.
+     * @param seed the seed from which candidates' seeds are drawn, or 0 for a random one.
+     * @param isCanceled polled by every worker before each candidate, from
+     *        several threads at once; once it returns true, the search stops.
+     */
+    Result generate(const GameBoard& board, std::uint64_t seed = 0, const std::function<bool()>& isCanceled = {}) const;
+
+    /**
+     * @brief The cell from which generated boards are solvable.  Corners never
+     *        hold mines, so it is always safe.  From anywhere else, the board
+     *        may still need a guess, so the player must be shown this cell.
+     */
+    static int startCell();
+
+    /**
+     * @brief Returns true if, starting from the given cell, the Solver alone
+     *        can clear the board.
+     */
+    static bool isSolvableFrom(GameState state, int start);
+
+private:
+    int m_threads;
+    qint64 m_timeMs;
+};
+
+#endif // NOGUESS_H
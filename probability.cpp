@@ -0,0 +1,671 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "probability.h"
+
+#include <QElapsedTimer>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+constexpr double kLogZero = -std::numeric_limits<double>::infinity();
+
+// What a DP state costs beyond its key and counts: the hash node, and the
+// string and vector headers within it.
+constexpr qsizetype kStateOverhead = 96;
+
+// Polynomials in the number of mines, with each coefficient held as its
+// logarithm: the counts involved easily exceed the range of a double.
+using LogPoly = std::vector<double>;
+
+double logAdd(double a, double b)
+{
+    if (a == kLogZero)
+    {
+        return b;
+    }
+    if (b == kLogZero)
+    {
+        return a;
+    }
+    return a > b ? a + std::log1p(std::exp(b - a)) : b + std::log1p(std::exp(a - b));
+}
+
+LogPoly logConvolve(const LogPoly& a, const LogPoly& b)
+{
+    LogPoly out(a.size() + b.size() - 1, kLogZero);
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        if (a[i] == kLogZero)
+        {
+            continue;
+        }
+        for (size_t j = 0; j < b.size(); ++j)
+        {
+            out[i + j] = logAdd(out[i + j], a[i] + b[j]);
+        }
+    }
+    return out;
+}
+
+double logBinomial(int n, int k)
+{
+    if (k < 0 || k > n)
+    {
+        return kLogZero;
+    }
+    return std::lgamma(n + 1.0) - std::lgamma(k + 1.0) - std::lgamma(n - k + 1.0);
+}
+
+// Counts held divided by exp(scale), back as logarithms of the true counts.
+LogPoly toLog(const std::vector<double>& counts, double scale)
+{
+    LogPoly out(counts.size());
+    std::transform(counts.begin(), counts.end(), out.begin(), [scale](double c) {
+        return c > 0 ? std::log(c) + scale : kLogZero;
+    });
+    return out;
+}
+
+} // namespace
+
+struct ProbabilityEngine::ComponentCounts
+{
+    ConstraintProblem::Component component; // what was counted, to confirm cache hits
+
+    bool exact{};
+    qsizetype peakStates{};
+
+    LogPoly configurations;                  // [k]: valid configurations with k mines
+    std::vector<LogPoly> mineConfigurations; // [cell][k]: those with a mine in the cell
+};
+
+// The components of one position, in the order ConstraintProblem gives them.
+// The counts themselves belong to the component cache, so a position never
+// keeps them alive; one that has been evicted there is simply counted again.
+struct ProbabilityEngine::PositionCounts
+{
+    int cols{};
+    std::vector<GameState::CellBits> cells; // the whole state, to confirm cache hits
+    std::vector<std::weak_ptr<const ComponentCounts>> counts;
+};
+
+namespace {
+
+using ComponentCounts = ProbabilityEngine::ComponentCounts;
+using PositionCounts = ProbabilityEngine::PositionCounts;
+
+// Memory for remembered positions: a thousand or so expert boards, enough
+// for the hints of the games played lately.
+constexpr qsizetype kPositionBytes = qsizetype{1} << 20;
+
+template <typename T>
+qsizetype bytesOf(const std::vector<T>& v)
+{
+    return static_cast<qsizetype>(v.capacity() * sizeof(T));
+}
+
+// What the component cache is charged for a component's counts.
+qsizetype bytesOf(const ComponentCounts& counts)
+{
+    qsizetype bytes = sizeof(ComponentCounts)
+                      + bytesOf(counts.component.cells)
+                      + bytesOf(counts.component.constraints)
+                      + bytesOf(counts.configurations)
+                      + bytesOf(counts.mineConfigurations);
+    for (const ConstraintProblem::Constraint& constraint : counts.component.constraints)
+    {
+        bytes += bytesOf(constraint.cells);
+    }
+    for (const LogPoly& mines : counts.mineConfigurations)
+    {
+        bytes += bytesOf(mines);
+    }
+    return bytes;
+}
+
+// What the position cache is charged for a position; its counts are only
+// referred to, and are charged to the component cache.
+qsizetype bytesOf(const PositionCounts& position)
+{
+    return sizeof(PositionCounts) + bytesOf(position.cells) + bytesOf(position.counts);
+}
+
+struct Enumeration
+{
+    const ConstraintProblem::Component* component{};
+    std::uint64_t key{};
+
+    std::shared_ptr<const ComponentCounts> counts;
+    bool cached{};
+    bool canceled{};
+    qint64 elapsedNs{};
+};
+
+// Counts the configurations of one component by dynamic programming over its
+// cells in order.  The state between two cells lists how many more mines are
+// needed by each constraint that has some cells on either side.
+//
+// Every forward layer is kept for the backward pass, so the memory budget is
+// spent on the states of all of them together.  Each state is charged as if
+// its key and counts were as long as they can get, which makes the budget a
+// bound: the backward pass holds at most two more layers, each no larger
+// than a forward one.
+//
+// Cancellation is polled before each layer, forward and backward.
+void enumerate(Enumeration& enumeration, qsizetype maxBytes, const std::function<bool()>& isCanceled)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    auto counts = std::make_shared<ComponentCounts>();
+    counts->component = *enumeration.component;
+    ComponentCounts& result = *counts;
+
+    auto finish = [&]() {
+        enumeration.counts = std::move(counts);
+        enumeration.elapsedNs = timer.nsecsElapsed();
+    };
+
+    auto canceled = [&]() {
+        if (!isCanceled || !isCanceled())
+        {
+            return false;
+        }
+
+        result.exact = false;
+        enumeration.canceled = true;
+        finish();
+        return true;
+    };
+
+    const auto& cells = result.component.cells;
+    const auto& constraints = result.component.constraints;
+    const int n = static_cast<int>(cells.size());
+    const int numConstraints = static_cast<int>(constraints.size());
+
+    std::vector<int> first(numConstraints, n);
+    std::vector<int> last(numConstraints, -1);
+    std::vector<std::vector<int>> constraintsAt(n);      // constraints covering each cell
+    std::vector<std::vector<int>> cellsAfter(n);         // parallel: their cells past this one
+    std::vector<std::vector<int>> open(n + 1);           // constraints spanning each boundary
+
+    for (int c = 0; c < numConstraints; ++c)
+    {
+        std::vector<int> positions = constraints[c].cells;
+        std::sort(positions.begin(), positions.end());
+
+        first[c] = positions.front();
+        last[c] = positions.back();
+
+        for (size_t p = 0; p < positions.size(); ++p)
+        {
+            constraintsAt[positions[p]].push_back(c);
+            cellsAfter[positions[p]].push_back(static_cast<int>(positions.size() - p - 1));
+        }
+
+        for (int boundary = first[c] + 1; boundary <= last[c]; ++boundary)
+        {
+            open[boundary].push_back(c);
+        }
+    }
+
+    // The per-cell mine counts of the backward pass come out of the budget first.
+    const qsizetype resultBytes = static_cast<qsizetype>(n) * (n + 1) * static_cast<qsizetype>(sizeof(double));
+    const qsizetype stateBytes = n + (n + 2) * static_cast<qsizetype>(sizeof(double)) + kStateOverhead;
+    const qsizetype maxStates = (maxBytes - resultBytes) / stateBytes;
+    qsizetype retainedStates = 1;
+
+    std::vector<int> need(numConstraints);
+
+    // Moves from the boundary before cell i to the one after it, with the
+    // cell a mine or not.  Returns false if that breaks some constraint.
+    auto transition = [&](int i, const std::string& state, int mine, std::string& next) {
+        for (size_t j = 0; j < open[i].size(); ++j)
+        {
+            need[open[i][j]] = state[j];
+        }
+
+        for (size_t j = 0; j < constraintsAt[i].size(); ++j)
+        {
+            const int c = constraintsAt[i][j];
+            if (first[c] == i)
+            {
+                need[c] = constraints[c].mines;
+            }
+
+            need[c] -= mine;
+            if (need[c] < 0 || need[c] > cellsAfter[i][j])
+            {
+                return false;
+            }
+        }
+
+        next.clear();
+        for (int c : open[i + 1])
+        {
+            next.push_back(static_cast<char>(need[c]));
+        }
+        return true;
+    };
+
+    using Layer = std::unordered_map<std::string, std::vector<double>>;
+
+    // Counts grow by up to a factor of two a cell, so a long enough strip
+    // would take them past the range of a double.  Each layer is therefore
+    // divided through by its largest count, and the logarithm of what it was
+    // divided by is carried alongside, to be added back in log space.
+    auto rescale = [](Layer& layer) {
+        double largest = 0.0;
+        for (const auto& [state, counts] : layer)
+        {
+            largest = std::max(largest, *std::max_element(counts.begin(), counts.end()));
+        }
+        if (largest == 0.0)
+        {
+            return 0.0;
+        }
+
+        for (auto& [state, counts] : layer)
+        {
+            for (double& count : counts)
+            {
+                count /= largest;
+            }
+        }
+        return std::log(largest);
+    };
+
+    // Forward: forward[i][state][k] is the number of ways to assign cells
+    // [0, i) with k mines, ending in the given state, divided by
+    // exp(forwardScale[i]).
+    std::vector<Layer> forward(n + 1);
+    std::vector<double> forwardScale(n + 1, 0.0);
+    forward[0].emplace(std::string{}, std::vector<double>{1.0});
+
+    std::string next;
+    for (int i = 0; i < n; ++i)
+    {
+        if (canceled())
+        {
+            return;
+        }
+
+        for (const auto& [state, counts] : forward[i])
+        {
+            for (int mine = 0; mine <= 1; ++mine)
+            {
+                if (!transition(i, state, mine, next))
+                {
+                    continue;
+                }
+
+                std::vector<double>& out = forward[i + 1][next];
+                if (out.empty())
+                {
+                    if (++retainedStates > maxStates)
+                    {
+                        result.peakStates = std::max(result.peakStates, static_cast<qsizetype>(forward[i + 1].size()));
+                        result.exact = false;
+                        finish();
+                        return;
+                    }
+                    out.assign(i + 2, 0.0);
+                }
+
+                for (size_t k = 0; k < counts.size(); ++k)
+                {
+                    out[k + mine] += counts[k];
+                }
+            }
+        }
+
+        result.peakStates = std::max(result.peakStates, static_cast<qsizetype>(forward[i + 1].size()));
+        forwardScale[i + 1] = forwardScale[i] + rescale(forward[i + 1]);
+    }
+
+    auto total = forward[n].find(std::string{});
+    result.configurations = total != forward[n].end()
+        ? toLog(total->second, forwardScale[n])
+        : LogPoly(n + 1, kLogZero);
+
+    // Backward: after[state][j] is the number of ways to assign the cells
+    // past the current boundary with j mines, starting from the given state,
+    // divided by exp(afterScale).  Together with the forward counts this
+    // gives, for each cell, how many configurations put a mine there; those
+    // of cell i are divided by exp(mineScale[i]).
+    std::vector<std::vector<double>> mineCounts(n, std::vector<double>(n + 1, 0.0));
+    std::vector<double> mineScale(n, 0.0);
+
+    Layer after;
+    double afterScale = 0.0;
+    after.emplace(std::string{}, std::vector<double>{1.0});
+
+    for (int i = n - 1; i >= 0; --i)
+    {
+        if (canceled())
+        {
+            return;
+        }
+
+        Layer current;
+        for (const auto& [state, counts] : forward[i])
+        {
+            std::vector<double> completions(n - i + 1, 0.0);
+
+            for (int mine = 0; mine <= 1; ++mine)
+            {
+                if (!transition(i, state, mine, next))
+                {
+                    continue;
+                }
+
+                auto found = after.find(next);
+                if (found == after.end())
+                {
+                    continue;
+                }
+
+                const std::vector<double>& rest = found->second;
+                for (size_t j = 0; j < rest.size(); ++j)
+                {
+                    completions[j + mine] += rest[j];
+                }
+
+                if (mine == 1)
+                {
+                    for (size_t k = 0; k < counts.size(); ++k)
+                    {
+                        if (counts[k] == 0)
+                        {
+                            continue;
+                        }
+                        for (size_t j = 0; j < rest.size(); ++j)
+                        {
+                            mineCounts[i][k + 1 + j] += counts[k] * rest[j];
+                        }
+                    }
+                }
+            }
+
+            current.emplace(state, std::move(completions));
+        }
+
+        mineScale[i] = forwardScale[i] + afterScale;
+        afterScale += rescale(current);
+
+        // Nothing further back needs the layer after this cell.
+        after = std::move(current);
+        Layer{}.swap(forward[i + 1]);
+    }
+
+    result.mineConfigurations.reserve(n);
+    for (int i = 0; i < n; ++i)
+    {
+        result.mineConfigurations.push_back(toLog(mineCounts[i], mineScale[i]));
+    }
+
+    result.exact = true;
+    finish();
+}
+
+} // namespace
+
+ProbabilityEngine::ProbabilityEngine(qsizetype maxBytes, qsizetype cacheBytes)
+    : m_maxBytes{maxBytes}
+    , m_cache{std::make_shared<Cache>(cacheBytes)}
+    , m_positions{std::make_shared<PositionCache>(kPositionBytes)}
+{
+}
+
+ProbabilityEngine::Result ProbabilityEngine::compute(const GameState& state, const Solver* solver, const std::function<bool()>& isCanceled) const
+{
+    return compute(state, ConstraintProblem::fromState(state, solver), isCanceled);
+}
+
+ProbabilityEngine::Result ProbabilityEngine::compute(const GameState& state, const ConstraintProblem& problem, const std::function<bool()>& isCanceled) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    Result result;
+    result.exact = true;
+    result.mineProbability.assign(state.size(), 0.0);
+
+    // The same state always gives the same problem, so a position found here
+    // has exactly these components, in this order.
+    std::shared_ptr<const PositionCounts> position;
+    if (problem.positionKey)
+    {
+        position = m_positions->find(*problem.positionKey, [&](const PositionCounts& p) {
+            return p.cols == state.cols()
+                   && p.counts.size() == problem.components.size()
+                   && p.cells == state.cells();
+        });
+    }
+
+    std::vector<Enumeration> enumerations(problem.components.size());
+    std::vector<Enumeration*> pending;
+    for (size_t c = 0; c < enumerations.size(); ++c)
+    {
+        Enumeration& e = enumerations[c];
+        e.component = &problem.components[c];
+        if (position != nullptr)
+        {
+            e.counts = position->counts[c].lock();
+        }
+        if (e.counts == nullptr)
+        {
+            e.key = e.component->key();
+            e.counts = m_cache->find(e.key, [&e](const ComponentCounts& counts) {
+                return counts.component == *e.component;
+            });
+        }
+
+        if (e.counts != nullptr)
+        {
+            e.cached = true;
+        }
+        else
+        {
+            pending.push_back(&e);
+        }
+    }
+
+    // Components are independent of one another, so enumerate them in parallel.
+    auto run = [maxBytes = m_maxBytes, &isCanceled](Enumeration* e) { enumerate(*e, maxBytes, isCanceled); };
+    if (pending.size() > 1)
+    {
+        QtConcurrent::blockingMap(pending, run);
+    }
+    else
+    {
+        std::for_each(pending.begin(), pending.end(), run);
+    }
+
+    // Counts given up on part way say nothing about the component.
+    for (Enumeration* e : pending)
+    {
+        if (e->canceled)
+        {
+            result.canceled = true;
+        }
+        else
+        {
+            m_cache->insert(e->key, e->counts, bytesOf(*e->counts));
+        }
+    }
+
+    result.enumerationNs = timer.nsecsElapsed();
+
+    if (result.canceled)
+    {
+        result.exact = false;
+        result.totalNs = timer.nsecsElapsed();
+        return result;
+    }
+
+    if (problem.positionKey && (position == nullptr || !pending.empty()))
+    {
+        auto seen = std::make_shared<PositionCounts>();
+        seen->cols = state.cols();
+        seen->cells = state.cells();
+        seen->counts.reserve(enumerations.size());
+        for (const Enumeration& e : enumerations)
+        {
+            seen->counts.push_back(e.counts);
+        }
+        const qsizetype bytes = bytesOf(*seen);
+        m_positions->insert(*problem.positionKey, std::move(seen), bytes);
+    }
+
+    // Cells of components too large to enumerate are lumped in with the
+    // interior, which is the best that can be said of them here.
+    std::vector<const Enumeration*> exact;
+    int interiorCells = static_cast<int>(problem.interior.size());
+
+    for (const Enumeration& e : enumerations)
+    {
+        result.components.push_back(ComponentStats{
+            static_cast<int>(e.component->cells.size()),
+            static_cast<int>(e.component->constraints.size()),
+            e.counts->peakStates,
+            e.elapsedNs,
+            e.counts->exact,
+            e.cached,
+        });
+
+        if (e.counts->exact)
+        {
+            exact.push_back(&e);
+        }
+        else
+        {
+            result.exact = false;
+            interiorCells += static_cast<int>(e.component->cells.size());
+        }
+    }
+
+    const int minesLeft = problem.minesLeft;
+    auto logInteriorWays = [&](int interiorMines) { return logBinomial(interiorCells, interiorMines); };
+
+    // prefix[c] and suffix[c] count configurations of components [0, c) and
+    // [c, end) by their number of mines, so that each component can be
+    // weighed against all the others.
+    const size_t numExact = exact.size();
+    std::vector<LogPoly> prefix(numExact + 1, LogPoly{0.0});
+    std::vector<LogPoly> suffix(numExact + 1, LogPoly{0.0});
+    for (size_t c = 0; c < numExact; ++c)
+    {
+        prefix[c + 1] = logConvolve(prefix[c], exact[c]->counts->configurations);
+    }
+    for (size_t c = numExact; c-- > 0;)
+    {
+        suffix[c] = logConvolve(exact[c]->counts->configurations, suffix[c + 1]);
+    }
+
+    const LogPoly& frontier = prefix[numExact];
+
+    double logTotal = kLogZero;
+    double logInteriorMines = kLogZero;
+    for (int t = 0; t < static_cast<int>(frontier.size()); ++t)
+    {
+        const double weight = frontier[t] + logInteriorWays(minesLeft - t);
+        logTotal = logAdd(logTotal, weight);
+        if (minesLeft - t > 0)
+        {
+            logInteriorMines = logAdd(logInteriorMines, weight + std::log(minesLeft - t));
+        }
+    }
+
+    if (logTotal == kLogZero)
+    {
+        // What's visible is inconsistent with the mine count; nothing can be said.
+        result.exact = false;
+        result.totalNs = timer.nsecsElapsed();
+        return result;
+    }
+
+    result.interiorProbability = interiorCells > 0
+        ? std::exp(logInteriorMines - logTotal - std::log(interiorCells))
+        : 0.0;
+
+    for (size_t c = 0; c < numExact; ++c)
+    {
+        const Enumeration& e = *exact[c];
+        const ComponentCounts& counts = *e.counts;
+        const LogPoly others = logConvolve(prefix[c], suffix[c + 1]);
+
+        // rest[k]: the weight of everything outside this component, given that
+        // it holds k mines.
+        LogPoly rest(counts.configurations.size(), kLogZero);
+        for (int k = 0; k < static_cast<int>(rest.size()); ++k)
+        {
+            for (int j = 0; j < static_cast<int>(others.size()); ++j)
+            {
+                rest[k] = logAdd(rest[k], others[j] + logInteriorWays(minesLeft - k - j));
+            }
+        }
+
+        double denominator = kLogZero;
+        for (size_t k = 0; k < rest.size(); ++k)
+        {
+            denominator = logAdd(denominator, counts.configurations[k] + rest[k]);
+        }
+
+        for (size_t i = 0; i < e.component->cells.size(); ++i)
+        {
+            double numerator = kLogZero;
+            for (size_t k = 0; k < rest.size(); ++k)
+            {
+                numerator = logAdd(numerator, counts.mineConfigurations[i][k] + rest[k]);
+            }
+
+            result.mineProbability[e.component->cells[i]] = std::exp(numerator - denominator);
+        }
+    }
+
+    for (const Enumeration& e : enumerations)
+    {
+        if (!e.counts->exact)
+        {
+            for (int ix : e.component->cells)
+            {
+                result.mineProbability[ix] = result.interiorProbability;
+            }
+        }
+    }
+
+    for (int ix : problem.interior)
+    {
+        result.mineProbability[ix] = result.interiorProbability;
+    }
+
+    for (int ix : problem.knownMines)
+    {
+        result.mineProbability[ix] = 1.0;
+    }
+
+    result.totalNs = timer.nsecsElapsed();
+    return result;
+}
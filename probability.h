@@ -0,0 +1,141 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef PROBABILITY_H
+#define PROBABILITY_H
+
+#include "constraintproblem.h"
+#include "gamestate.h"
+#include "solver.h"
+#include "transpositioncache.h"
+
+#include <QtGlobal>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Computes the exact probability that each unrevealed cell is a mine,
+ *        given everything the player can see.
+ *
+ * Each independent component of the frontier is enumerated on its own, in
+ * parallel, by dynamic programming over its cells in order: the state after
+ * each cell is how many more mines each partially-assigned constraint still
+ * needs, so configurations that agree on that share all later work.  This
+ * yields, for every possible number of mines in the component, the number
+ * of valid configurations and how many of them put a mine in each cell.
+ *
+ * Components are then combined under the total mine count, with the mines
+ * not on the frontier spread over the interior: a frontier configuration
+ * with k mines is weighted by C(interior cells, mines left - k).
+ *
+ * A component's counts depend only on its own cells and constraints, so
+ * they are kept in a transposition cache keyed by the component's Zobrist
+ * hash.  As the player works through a board, most components are unchanged
+ * from one position to the next, and only those a move touched are counted
+ * again.  Positions themselves are remembered too, under the incremental
+ * GameState::knowledgeHash(): a position seen before, as when a hint is
+ * asked for again, names the counts of its components without any of them
+ * being hashed or compared.  Copies of an engine share both caches.
+ */
+class ProbabilityEngine
+{
+public:
+    struct ComponentStats
+    {
+        int cells{};
+        int constraints{};
+        qsizetype peakStates{}; // the most distinct states at any one cell
+        qint64 elapsedNs{};
+        bool exact{};
+        bool cached{}; // answered from the cache rather than enumerated
+    };
+
+    struct Result
+    {
+        /**
+         * @brief False if some component had too many states to enumerate.
+         *        Its cells are then given the interior probability as a
+         *        stand-in, and an estimate should be used instead.
+         */
+        bool exact{};
+
+        /**
+         * @brief True if the computation was cancelled before it finished;
+         *        nothing else in the result is then meaningful.
+         */
+        bool canceled{};
+
+        /**
+         * @brief The probability that each cell is a mine; 0 for revealed cells.
+         */
+        std::vector<double> mineProbability;
+
+        /**
+         * @brief The probability shared by every interior cell.
+         */
+        double interiorProbability{};
+
+        std::vector<ComponentStats> components;
+        qint64 enumerationNs{};
+        qint64 totalNs{};
+    };
+
+    /**
+     * @param maxBytes roughly the most memory that enumerating one component
+     *        may hold before it is abandoned as too large.  Every DP state is
+     *        kept until the backward pass, so this caps the states over all
+     *        of a component's cells, not just at any one of them.
+     * @param cacheBytes roughly the most memory that the counts of components
+     *        already enumerated may hold; past it, those least recently used
+     *        are forgotten.
+     */
+    explicit ProbabilityEngine(qsizetype maxBytes = qsizetype{64} << 20, qsizetype cacheBytes = qsizetype{32} << 20);
+
+    /**
+     * @param isCanceled polled between the DP layers of every component, from
+     *        whichever threads are enumerating them; once it returns true, the
+     *        computation gives up and the result is marked as cancelled.
+     *        Components given up on are not cached.
+     */
+    Result compute(const GameState& state, const Solver* solver = nullptr, const std::function<bool()>& isCanceled = {}) const;
+    Result compute(const GameState& state, const ConstraintProblem& problem, const std::function<bool()>& isCanceled = {}) const;
+
+    struct ComponentCounts;
+    struct PositionCounts;
+    using Cache = TranspositionCache<ComponentCounts>;
+    using PositionCache = TranspositionCache<PositionCounts>;
+
+    /**
+     * @brief How often components have been found in the cache, over every
+     *        engine sharing it.
+     */
+    Cache::Stats cacheStats() const { return m_cache->stats(); }
+
+    /**
+     * @brief How often whole positions have been found in the cache.
+     */
+    PositionCache::Stats positionCacheStats() const { return m_positions->stats(); }
+
+private:
+    qsizetype m_maxBytes;
+    std::shared_ptr<Cache> m_cache;
+    std::shared_ptr<PositionCache> m_positions;
+};
+
+#endif // PROBABILITY_H
@@ -0,0 +1,295 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "recording.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+constexpr char kMagic[4] = {'M', 'N', 'R', 'C'};
+constexpr qsizetype kPreambleSize = 6;
+constexpr qsizetype kChecksumSize = 2;
+constexpr int kActionBits = 2;
+
+// As in SaveGame, keeps a corrupt header from asking for absurd allocations.
+constexpr qint64 kMaxCells = qint64{1} << 24;
+
+void putVarint(QByteArray& bytes, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        bytes.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    bytes.append(static_cast<char>(value));
+}
+
+// Reads a varint at pos and advances past it, or returns false if the bytes
+// run out or it doesn't fit in 64 bits.
+bool getVarint(QByteArrayView bytes, qsizetype& pos, std::uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (pos >= bytes.size())
+        {
+            return false;
+        }
+
+        const auto byte = static_cast<std::uint8_t>(bytes[pos++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::uint64_t zigzag(qint64 value)
+{
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+qint64 unzigzag(std::uint64_t value)
+{
+    return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+}
+
+} // namespace
+
+Recording::Recording(GameBoard board, std::uint64_t seed)
+    : m_board{board}
+    , m_seed{seed}
+{
+}
+
+void Recording::append(Move move)
+{
+    Q_ASSERT(m_moves.empty() || move.timeUs >= m_moves.back().timeUs);
+    m_moves.push_back(move);
+}
+
+bool Recording::isLegal(const GameState& state, Action action, int cell)
+{
+    if (cell < 0 || cell >= state.size())
+    {
+        return false;
+    }
+
+    switch (action)
+    {
+    case Action::Reveal:
+        return !state.isRevealed(cell);
+    case Action::Flag:
+        return !state.isRevealed(cell) && !state.isFlagged(cell);
+    case Action::Unflag:
+        return state.isFlagged(cell);
+    case Action::Chord:
+        return !state.chordCells(cell).empty();
+    }
+    return false;
+}
+
+bool Recording::apply(GameState& state, const Move& move)
+{
+    if (!isLegal(state, move.action, move.cell))
+    {
+        return false;
+    }
+
+    switch (move.action)
+    {
+    case Action::Reveal:
+        state.revealArea(move.cell);
+        break;
+    case Action::Flag:
+    case Action::Unflag:
+        state.toggleFlag(move.cell);
+        break;
+    case Action::Chord:
+        state.revealCells(state.chordCells(move.cell));
+        break;
+    }
+    return true;
+}
+
+Recording::Outcome Recording::verify() const
+{
+    Outcome outcome;
+
+    GameState state{m_board, m_seed};
+    for (const Move& move : m_moves)
+    {
+        if (outcome.won || outcome.lost || !apply(state, move))
+        {
+            return outcome;
+        }
+
+        outcome.timeUs = move.timeUs;
+        outcome.won = state.isSolved();
+
+        // Only a reveal or a chord can set off a mine, and only around its own cell.
+        if (move.action == Action::Reveal)
+        {
+            outcome.lost = state.isMine(move.cell);
+        }
+        else if (move.action == Action::Chord)
+        {
+            state.forEachNeighbor(move.cell, [&](int n) { outcome.lost |= state.isRevealed(n) && state.isMine(n); });
+        }
+    }
+
+    outcome.valid = true;
+    return outcome;
+}
+
+QByteArray Recording::encode() const
+{
+    QByteArray bytes;
+    bytes.reserve(kPreambleSize + 24 + static_cast<qsizetype>(m_moves.size()) * 4 + kChecksumSize);
+
+    bytes.append(kMagic, sizeof(kMagic));
+    char version[2];
+    qToLittleEndian<quint16>(kVersion, version);
+    bytes.append(version, sizeof(version));
+
+    putVarint(bytes, static_cast<std::uint64_t>(m_board.rows()));
+    putVarint(bytes, static_cast<std::uint64_t>(m_board.cols()));
+    putVarint(bytes, static_cast<std::uint64_t>(m_board.mines()));
+    putVarint(bytes, m_seed);
+    putVarint(bytes, m_moves.size());
+
+    qint64 lastTime = 0;
+    int lastCell = 0;
+    for (const Move& move : m_moves)
+    {
+        putVarint(bytes, static_cast<std::uint64_t>(move.timeUs - lastTime));
+        putVarint(bytes, (zigzag(move.cell - lastCell) << kActionBits) | static_cast<std::uint64_t>(move.action));
+        lastTime = move.timeUs;
+        lastCell = move.cell;
+    }
+
+    char checksum[2];
+    qToLittleEndian<quint16>(qChecksum(bytes), checksum);
+    bytes.append(checksum, sizeof(checksum));
+    return bytes;
+}
+
+std::optional<Recording> Recording::decode(QByteArrayView bytes)
+{
+    if (bytes.size() < kPreambleSize + kChecksumSize
+        || !std::equal(std::begin(kMagic), std::end(kMagic), bytes.begin())
+        || qFromLittleEndian<quint16>(bytes.data() + 4) != kVersion)
+    {
+        return std::nullopt;
+    }
+
+    const qsizetype body = bytes.size() - kChecksumSize;
+    if (qFromLittleEndian<quint16>(bytes.data() + body) != qChecksum(bytes.first(body)))
+    {
+        return std::nullopt;
+    }
+    bytes = bytes.first(body);
+
+    qsizetype pos = kPreambleSize;
+    std::uint64_t rows = 0;
+    std::uint64_t cols = 0;
+    std::uint64_t mines = 0;
+    std::uint64_t seed = 0;
+    std::uint64_t count = 0;
+    if (!getVarint(bytes, pos, rows) || !getVarint(bytes, pos, cols) || !getVarint(bytes, pos, mines)
+        || !getVarint(bytes, pos, seed) || !getVarint(bytes, pos, count))
+    {
+        return std::nullopt;
+    }
+
+    // Every move takes at least two bytes, which bounds the count before
+    // anything is allocated for it.
+    if (rows == 0 || cols == 0 || rows > kMaxCells || cols > kMaxCells || rows * cols > kMaxCells
+        || mines > rows * cols || seed == 0 || count > static_cast<std::uint64_t>(body - pos) / 2)
+    {
+        return std::nullopt;
+    }
+
+    Recording recording{GameBoard{static_cast<int>(rows), static_cast<int>(cols), static_cast<int>(mines)}, seed};
+    recording.m_moves.reserve(count);
+
+    qint64 time = 0;
+    qint64 cell = 0;
+    for (std::uint64_t ix = 0; ix < count; ++ix)
+    {
+        std::uint64_t delta = 0;
+        std::uint64_t packed = 0;
+        if (!getVarint(bytes, pos, delta) || !getVarint(bytes, pos, packed) || delta > static_cast<std::uint64_t>(std::numeric_limits<qint64>::max() - time))
+        {
+            return std::nullopt;
+        }
+
+        time += static_cast<qint64>(delta);
+        cell += unzigzag(packed >> kActionBits);
+        if (cell < 0 || cell >= static_cast<qint64>(rows * cols))
+        {
+            return std::nullopt;
+        }
+
+        recording.m_moves.push_back(Move{static_cast<Action>(packed & ((1 << kActionBits) - 1)), static_cast<int>(cell), time});
+    }
+
+    if (pos != bytes.size())
+    {
+        return std::nullopt;
+    }
+    return recording;
+}
+
+bool Recording::save(const QString& path) const
+{
+    QSaveFile file{path};
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    const QByteArray bytes = encode();
+    return file.write(bytes) == bytes.size() && file.commit();
+}
+
+std::optional<Recording> Recording::load(const QString& path)
+{
+    QFile file{path};
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return std::nullopt;
+    }
+
+    const uchar* mapped = file.map(0, file.size());
+    if (mapped == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    std::optional<Recording> recording = decode(QByteArrayView{mapped, file.size()});
+    file.unmap(const_cast<uchar*>(mapped));
+    return recording;
+}
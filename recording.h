@@ -0,0 +1,139 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include "gameboard.h"
+#include "gamestate.h"
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <QtGlobal>
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Every move of one game, in order, with when it was made.
+ *
+ * Together with the board and the seed that laid its mines, that is enough
+ * to play the game again move for move, either on screen or headlessly with
+ * verify().
+ *
+ * On disk a recording is a little-endian stream:
+ *
+ *   magic "MNRC", then a 2-byte format version, currently 1;
+ *   varints of rows, columns, mines, seed and the number of moves;
+ *   for each move, a varint of the microseconds since the one before, then
+ *   a varint of the zigzagged distance from the previous move's cell
+ *   shifted left by 2, with the action in the low 2 bits;
+ *   and a 2-byte CRC-16 (ISO 3309) of everything before it.
+ *
+ * Players mostly work outwards from where they are, a second or so apart,
+ * so a move usually costs four or five bytes.
+ */
+class Recording
+{
+public:
+    static constexpr quint16 kVersion = 1;
+
+    enum class Action : quint8
+    {
+        Reveal,
+        Flag,
+        Unflag,
+        Chord,
+    };
+
+    struct Move
+    {
+        Action action{};
+        int cell{};
+        qint64 timeUs{}; // since the first move
+
+        bool operator==(const Move&) const = default;
+    };
+
+    /**
+     * @brief How a recording plays out.
+     */
+    struct Outcome
+    {
+        bool valid{};  // every move was legal where it was made, and none came after the end
+        bool won{};
+        bool lost{};
+        qint64 timeUs{}; // when the last move was made
+    };
+
+    /**
+     * @brief Starts an empty recording of the game the given seed deals;
+     *        see GameState(GameBoard, std::uint64_t).
+     */
+    Recording(GameBoard board, std::uint64_t seed);
+
+    const GameBoard& board() const { return m_board; }
+    std::uint64_t seed() const { return m_seed; }
+    const std::vector<Move>& moves() const { return m_moves; }
+
+    /**
+     * @brief Adds a move, which must come no earlier than the last one.
+     */
+    void append(Move move);
+
+    /**
+     * @brief Plays every move on a fresh board, checking each against the
+     *        rules, without drawing anything.
+     *
+     * A reveal must be of a covered cell, flagged or not, as a click on a
+     * flag reveals it; a flag of a covered, unflagged one; an unflag of a
+     * flagged one; and a chord must uncover something.  The moves must also
+     * stay within the board and stop when the game is won or lost.
+     */
+    Outcome verify() const;
+
+    /**
+     * @brief Whether verify() would accept the given move in the given position.
+     */
+    static bool isLegal(const GameState& state, Action action, int cell);
+
+    /**
+     * @brief Makes one move on the given game, as verify() does.  Returns
+     *        whether the move was legal; an illegal one changes nothing.
+     */
+    static bool apply(GameState& state, const Move& move);
+
+    QByteArray encode() const;
+
+    /**
+     * @brief Reads a recording written by encode(), or returns nothing if
+     *        the bytes are truncated, corrupt, or of an unknown version.
+     */
+    static std::optional<Recording> decode(QByteArrayView bytes);
+
+    bool save(const QString& path) const;
+    static std::optional<Recording> load(const QString& path);
+
+private:
+    GameBoard m_board;
+    std::uint64_t m_seed;
+    std::vector<Move> m_moves;
+};
+
+#endif // RECORDING_H
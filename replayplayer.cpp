@@ -0,0 +1,81 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "replayplayer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+ReplayPlayer::ReplayPlayer(Recording recording, MineField* field, double speed)
+    : QObject{field}
+    , m_recording{std::move(recording)}
+    , m_field{field}
+    , m_speed{speed}
+    , m_next{0}
+    , m_timer{new QTimer(this)}
+{
+    m_timer->setSingleShot(true);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    connect(m_timer, &QTimer::timeout, this, &ReplayPlayer::advance);
+}
+
+void ReplayPlayer::start()
+{
+    m_elapsed.start();
+    advance();
+}
+
+void ReplayPlayer::advance()
+{
+    const std::vector<Recording::Move>& moves = m_recording.moves();
+
+    const double now = m_speed == kAsFastAsPossible
+        ? std::numeric_limits<double>::infinity()
+        : m_elapsed.nsecsElapsed() / 1000.0 * m_speed;
+    while (m_next < moves.size() && moves[m_next].timeUs <= now)
+    {
+        play(moves[m_next++]);
+    }
+
+    if (m_next == moves.size())
+    {
+        emit finished();
+        return;
+    }
+
+    const double dueUs = moves[m_next].timeUs / m_speed;
+    const double waitMs = (dueUs - m_elapsed.nsecsElapsed() / 1000.0) / 1000.0;
+    m_timer->start(static_cast<int>(std::clamp(std::ceil(waitMs), 0.0, static_cast<double>(std::numeric_limits<int>::max()))));
+}
+
+void ReplayPlayer::play(const Recording::Move& move)
+{
+    switch (move.action)
+    {
+    case Recording::Action::Reveal:
+        m_field->revealCells({move.cell});
+        break;
+    case Recording::Action::Flag:
+    case Recording::Action::Unflag:
+        m_field->toggleFlag(move.cell);
+        break;
+    case Recording::Action::Chord:
+        m_field->chord(move.cell);
+        break;
+    }
+}
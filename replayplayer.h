@@ -0,0 +1,70 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef REPLAYPLAYER_H
+#define REPLAYPLAYER_H
+
+#include "minefield.h"
+#include "recording.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+/**
+ * @brief Plays a Recording back on a MineField, at a multiple of the speed
+ *        it was played at, or all at once.
+ *
+ * Rather than polling, the player sleeps until the next move is due, so a
+ * long think in the recording costs no wakeups.  Played all at once, every
+ * move is made before control returns to the event loop, and the field
+ * paints only the final position.
+ */
+class ReplayPlayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr double kAsFastAsPossible = 0.0;
+
+    /**
+     * @param field the field to play on, which must show the recording's
+     *        fresh board; it becomes the player's parent.
+     * @param speed how many times faster than recorded, or kAsFastAsPossible.
+     */
+    ReplayPlayer(Recording recording, MineField* field, double speed);
+
+    void start();
+
+signals:
+    void finished();
+
+private slots:
+    void advance();
+
+private:
+    void play(const Recording::Move& move);
+
+    Recording m_recording;
+    MineField* m_field;
+    double m_speed;
+    size_t m_next;          // the first move not yet played
+    QElapsedTimer m_elapsed;
+    QTimer* m_timer;
+};
+
+#endif // REPLAYPLAYER_H
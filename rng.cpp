@@ -0,0 +1,33 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "rng.h"
+
+#include <chrono>
+#include <random>
+
+std::uint64_t Rng::randomSeed()
+{
+    thread_local Rng seeds{[] {
+        std::random_device device;
+        const std::uint64_t entropy = (static_cast<std::uint64_t>(device()) << 32) | device();
+        const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+        return entropy ^ static_cast<std::uint64_t>(now);
+    }()};
+
+    return seeds();
+}
@@ -0,0 +1,145 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+#include <limits>
+
+/**
+ * @brief A small, fast, seedable random number generator (xoshiro256**).
+ *
+ * Unlike the standard library's engines and distributions, its output is
+ * fully specified, so a board generated from a given seed is the same on
+ * every platform.  Satisfies UniformRandomBitGenerator.
+ */
+class Rng
+{
+public:
+    using result_type = std::uint64_t;
+
+    explicit Rng(std::uint64_t seed)
+    {
+        // Expand the seed with splitmix64, as the xoshiro authors recommend.
+        for (std::uint64_t& s : m_state)
+        {
+            seed += 0x9e3779b97f4a7c15ULL;
+            std::uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            s = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        const std::uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+        const std::uint64_t t = m_state[1] << 17;
+
+        m_state[2] ^= m_state[0];
+        m_state[3] ^= m_state[1];
+        m_state[1] ^= m_state[2];
+        m_state[0] ^= m_state[3];
+
+        m_state[2] ^= t;
+        m_state[3] = rotl(m_state[3], 45);
+
+        return result;
+    }
+
+    /**
+     * @brief Returns a uniformly-distributed value in [0, bound), without modulo bias.
+     */
+    std::uint32_t bounded(std::uint32_t bound)
+    {
+        // Lemire, "Fast Random Integer Generation in an Interval" (2019).
+        std::uint64_t m = static_cast<std::uint64_t>(static_cast<std::uint32_t>(operator()() >> 32)) * bound;
+        std::uint32_t low = static_cast<std::uint32_t>(m);
+        if (low < bound)
+        {
+            const std::uint32_t threshold = static_cast<std::uint32_t>(-bound) % bound;
+            while (low < threshold)
+            {
+                m = static_cast<std::uint64_t>(static_cast<std::uint32_t>(operator()() >> 32)) * bound;
+                low = static_cast<std::uint32_t>(m);
+            }
+        }
+        return static_cast<std::uint32_t>(m >> 32);
+    }
+
+    /**
+     * @brief Returns a uniformly-distributed value in [0, 1).
+     */
+    double uniform()
+    {
+        return static_cast<double>(operator()() >> 11) * 0x1.0p-53;
+    }
+
+    /**
+     * @brief Advances the generator by 2^128 steps.  Calling this repeatedly on
+     *        copies of one generator yields non-overlapping streams, one per thread.
+     */
+    void jump()
+    {
+        static constexpr std::uint64_t kJump[] = {
+            0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+        };
+
+        std::uint64_t s[4] = {};
+        for (std::uint64_t word : kJump)
+        {
+            for (int b = 0; b < 64; ++b)
+            {
+                if (word & (std::uint64_t{1} << b))
+                {
+                    for (int i = 0; i < 4; ++i)
+                    {
+                        s[i] ^= m_state[i];
+                    }
+                }
+                operator()();
+            }
+        }
+
+        for (int i = 0; i < 4; ++i)
+        {
+            m_state[i] = s[i];
+        }
+    }
+
+    /**
+     * @brief Returns a fresh seed for a new game.
+     *
+     * The OS entropy source is consulted once per thread; later seeds are drawn
+     * from a generator seeded with it.
+     */
+    static std::uint64_t randomSeed();
+
+private:
+    static std::uint64_t rotl(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    std::uint64_t m_state[4];
+};
+
+#endif // RNG_H
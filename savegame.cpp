@@ -0,0 +1,206 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "savegame.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+constexpr char kMagic[4] = {'M', 'N', 'S', 'V'};
+constexpr quint16 kHasMinePlane = 0x0001;
+
+constexpr qsizetype kHeaderSize = 36;
+constexpr qsizetype kChecksumSize = 2;
+
+// Keeps a corrupt header from asking for an absurd allocation; far larger
+// than any board the game offers.
+constexpr qint64 kMaxCells = qint64{1} << 24;
+
+qsizetype planeSize(qint64 cells)
+{
+    return static_cast<qsizetype>((cells + 7) / 8);
+}
+
+template <typename T>
+void put(QByteArray& bytes, qsizetype offset, T value)
+{
+    qToLittleEndian<T>(value, bytes.data() + offset);
+}
+
+template <typename T>
+T get(QByteArrayView bytes, qsizetype offset)
+{
+    return qFromLittleEndian<T>(bytes.data() + offset);
+}
+
+void packPlane(const std::vector<GameState::CellBits>& cells, GameState::CellBits bit, char* plane)
+{
+    for (size_t ix = 0; ix < cells.size(); ++ix)
+    {
+        if (cells[ix] & bit)
+        {
+            plane[ix / 8] = static_cast<char>(plane[ix / 8] | (1 << (ix % 8)));
+        }
+    }
+}
+
+template <typename Fn>
+void forEachSetBit(const char* plane, int cells, Fn&& fn)
+{
+    for (int ix = 0; ix < cells; ++ix)
+    {
+        if (static_cast<unsigned char>(plane[ix / 8]) & (1 << (ix % 8)))
+        {
+            fn(ix);
+        }
+    }
+}
+
+} // namespace
+
+QByteArray SaveGame::encode(const GameState& state, qint64 elapsedUs)
+{
+    const bool minePlane = state.seed() == 0;
+    const qsizetype plane = planeSize(state.size());
+
+    QByteArray bytes(kHeaderSize + plane * (minePlane ? 3 : 2) + kChecksumSize, '\0');
+
+    std::copy(std::begin(kMagic), std::end(kMagic), bytes.begin());
+    put<quint16>(bytes, 4, kVersion);
+    put<quint16>(bytes, 6, minePlane ? kHasMinePlane : 0);
+    put<qint32>(bytes, 8, state.rows());
+    put<qint32>(bytes, 12, state.cols());
+    put<qint32>(bytes, 16, state.mineCount());
+    put<quint64>(bytes, 20, state.seed());
+    put<qint64>(bytes, 28, elapsedUs);
+
+    char* planes = bytes.data() + kHeaderSize;
+    packPlane(state.cells(), GameState::kRevealedBit, planes);
+    packPlane(state.cells(), GameState::kFlaggedBit, planes + plane);
+    if (minePlane)
+    {
+        packPlane(state.cells(), GameState::kMineBit, planes + 2 * plane);
+    }
+
+    const qsizetype body = bytes.size() - kChecksumSize;
+    put<quint16>(bytes, body, qChecksum(QByteArrayView{bytes.constData(), body}));
+    return bytes;
+}
+
+std::optional<SaveGame::Snapshot> SaveGame::decode(QByteArrayView bytes)
+{
+    if (bytes.size() < kHeaderSize + kChecksumSize
+        || !std::equal(std::begin(kMagic), std::end(kMagic), bytes.begin())
+        || get<quint16>(bytes, 4) != kVersion)
+    {
+        return std::nullopt;
+    }
+
+    const quint16 flags = get<quint16>(bytes, 6);
+    const qint32 rows = get<qint32>(bytes, 8);
+    const qint32 cols = get<qint32>(bytes, 12);
+    const qint32 mines = get<qint32>(bytes, 16);
+    const quint64 seed = get<quint64>(bytes, 20);
+    const qint64 elapsed = get<qint64>(bytes, 28);
+
+    const bool minePlane = (flags & kHasMinePlane) != 0;
+    if (rows <= 0 || cols <= 0 || qint64{rows} * cols > kMaxCells
+        || mines < 0 || mines > rows * cols || elapsed < 0
+        || minePlane == (seed != 0))
+    {
+        return std::nullopt;
+    }
+
+    const int cells = rows * cols;
+    const qsizetype plane = planeSize(cells);
+    const qsizetype body = kHeaderSize + plane * (minePlane ? 3 : 2);
+    if (bytes.size() != body + kChecksumSize
+        || get<quint16>(bytes, body) != qChecksum(bytes.first(body)))
+    {
+        return std::nullopt;
+    }
+
+    const GameBoard board{rows, cols, mines};
+    const char* planes = bytes.data() + kHeaderSize;
+
+    std::optional<GameState> state;
+    if (minePlane)
+    {
+        std::vector<int> mineIndices;
+        forEachSetBit(planes + 2 * plane, cells, [&](int ix) { mineIndices.push_back(ix); });
+        state.emplace(board, mineIndices);
+    }
+    else
+    {
+        state.emplace(board, seed);
+    }
+
+    if (state->mineCount() != mines)
+    {
+        return std::nullopt;
+    }
+
+    std::vector<int> revealed;
+    forEachSetBit(planes, cells, [&](int ix) { revealed.push_back(ix); });
+    state->revealCells(revealed);
+
+    forEachSetBit(planes + plane, cells, [&](int ix) {
+        if (!state->isRevealed(ix))
+        {
+            state->toggleFlag(ix);
+        }
+    });
+
+    return Snapshot{std::move(*state), elapsed};
+}
+
+bool SaveGame::save(const QString& path, const GameState& state, qint64 elapsedUs)
+{
+    QSaveFile file{path};
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    const QByteArray bytes = encode(state, elapsedUs);
+    return file.write(bytes) == bytes.size() && file.commit();
+}
+
+std::optional<SaveGame::Snapshot> SaveGame::load(const QString& path)
+{
+    QFile file{path};
+    if (!file.open(QIODevice::ReadOnly) || file.size() < kHeaderSize + kChecksumSize)
+    {
+        return std::nullopt;
+    }
+
+    const uchar* mapped = file.map(0, file.size());
+    if (mapped == nullptr)
+    {
+        return std::nullopt;
+    }
+
+    std::optional<Snapshot> snapshot = decode(QByteArrayView{mapped, file.size()});
+    file.unmap(const_cast<uchar*>(mapped));
+    return snapshot;
+}
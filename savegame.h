@@ -0,0 +1,86 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SAVEGAME_H
+#define SAVEGAME_H
+
+#include "gamestate.h"
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+
+#include <optional>
+
+/**
+ * @brief A compact, versioned binary snapshot of a game in progress.
+ *
+ * The mines are not stored, only the seed that lays them, followed by the
+ * revealed and flagged cells as bit planes, so that a 75x75 game takes about
+ * 1.4 KB.  A game whose mines were given explicitly has no seed, and carries
+ * a third plane with its mines instead.  All fields are little-endian:
+ *
+ *   offset  size  field
+ *        0     4  magic, "MNSV"
+ *        4     2  format version, currently 1
+ *        6     2  flags: bit 0 set if a mine plane follows the others
+ *        8     4  rows
+ *       12     4  columns
+ *       16     4  mines
+ *       20     8  seed
+ *       28     8  microseconds played
+ *       36     -  revealed plane, then flagged plane, then any mine plane;
+ *                 each ceil(rows * columns / 8) bytes, cell i in bit i % 8
+ *                 of byte i / 8
+ *   end - 2    2  CRC-16 (ISO 3309) of everything before it
+ *
+ * Version 1 relies on GameState(board, seed) always laying the same mines;
+ * a change to board generation must bump the version.
+ */
+class SaveGame
+{
+public:
+    static constexpr quint16 kVersion = 1;
+
+    struct Snapshot
+    {
+        GameState state;
+        qint64 elapsedUs{};
+    };
+
+    static QByteArray encode(const GameState& state, qint64 elapsedUs);
+
+    /**
+     * @brief Rebuilds the game that encode() stored, or returns nothing if
+     *        the bytes are truncated, corrupt, or of an unknown version.
+     */
+    static std::optional<Snapshot> decode(QByteArrayView bytes);
+
+    /**
+     * @brief Writes a snapshot to the given file, atomically: a failed save
+     *        leaves any previous one intact.
+     */
+    static bool save(const QString& path, const GameState& state, qint64 elapsedUs);
+
+    /**
+     * @brief Reads a snapshot from the given file, which is mapped into
+     *        memory and decoded in place rather than read into a buffer.
+     */
+    static std::optional<Snapshot> load(const QString& path);
+};
+
+#endif // SAVEGAME_H
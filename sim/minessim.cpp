@@ -0,0 +1,206 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Plays many games headlessly against a strategy and reports how it fares:
+//
+//   mines_sim --board large --strategy probability --games 1000000
+//   mines_sim --rows 30 --cols 30 --mines 200 --strategy solver
+//   mines_sim --verify replays/*.mrec
+//
+// Needs only QtCore, so it runs on machines without a display.
+
+#include "gameboard.h"
+#include "recording.h"
+#include "simulator.h"
+#include "strategy.h"
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstdio>
+#include <optional>
+
+namespace {
+
+bool parseInt(const QString& text, qint64 min, qint64& out)
+{
+    bool ok = false;
+    out = text.toLongLong(&ok);
+    return ok && out >= min;
+}
+
+// Replays each recording and checks it against the rules, with one line per
+// recording and a summary, as a leaderboard would before accepting a time.
+int verifyRecordings(const QStringList& paths)
+{
+    QTextStream out{stdout};
+    qint64 valid = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (const QString& path : paths)
+    {
+        const std::optional<Recording> recording = Recording::load(path);
+        if (!recording)
+        {
+            out << path << ": unreadable\n";
+            continue;
+        }
+
+        const Recording::Outcome outcome = recording->verify();
+        const QString time = QString::number(outcome.timeUs / 1e6, 'f', 3);
+        if (!outcome.valid)
+        {
+            out << path << ": INVALID\n";
+            continue;
+        }
+
+        ++valid;
+        if (outcome.won)
+        {
+            out << path << ": won in " << time << " s\n";
+        }
+        else if (outcome.lost)
+        {
+            out << path << ": lost after " << time << " s\n";
+        }
+        else
+        {
+            out << path << ": unfinished\n";
+        }
+    }
+    const qint64 elapsedNs = std::max<qint64>(timer.nsecsElapsed(), 1);
+
+    out << "recordings:            " << paths.size() << " (" << valid << " valid)\n"
+        << "recordings per second: " << QString::number(paths.size() * 1e9 / elapsedNs, 'f', 0) << "\n";
+
+    return valid == paths.size() ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("mines_sim"));
+    QCoreApplication::setApplicationVersion("0.1.0");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Plays games of Mines against a strategy, on every core."));
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    const QCommandLineOption boardOption{
+        QStringLiteral("board"), QStringLiteral("A preset size: small, medium or large."), QStringLiteral("size"), QStringLiteral("large")};
+    const QCommandLineOption rowsOption{QStringLiteral("rows"), QStringLiteral("Rows, for a custom size."), QStringLiteral("n")};
+    const QCommandLineOption colsOption{QStringLiteral("cols"), QStringLiteral("Columns, for a custom size."), QStringLiteral("n")};
+    const QCommandLineOption minesOption{QStringLiteral("mines"), QStringLiteral("Mines, for a custom size."), QStringLiteral("n")};
+    const QCommandLineOption strategyOption{
+        QStringLiteral("strategy"),
+        QStringLiteral("How to play: %1.").arg(Strategy::names().join(QStringLiteral(", "))),
+        QStringLiteral("name"),
+        QStringLiteral("probability")};
+    const QCommandLineOption gamesOption{QStringLiteral("games"), QStringLiteral("Games to play."), QStringLiteral("n"), QStringLiteral("10000")};
+    const QCommandLineOption threadsOption{
+        QStringLiteral("threads"), QStringLiteral("Games to play at once; 0 for one per core."), QStringLiteral("n"), QStringLiteral("0")};
+    const QCommandLineOption seedOption{
+        QStringLiteral("seed"), QStringLiteral("Seed for the whole run; 0 for a random one."), QStringLiteral("n"), QStringLiteral("0")};
+
+    const QCommandLineOption verifyOption{
+        QStringLiteral("verify"), QStringLiteral("Instead of playing, replay the given recordings and check that each follows the rules.")};
+
+    parser.addOptions({boardOption, rowsOption, colsOption, minesOption, strategyOption, gamesOption, threadsOption, seedOption, verifyOption});
+    parser.addPositionalArgument(QStringLiteral("recordings"), QStringLiteral("With --verify, the recordings to check."), QStringLiteral("[recordings...]"));
+    parser.process(app);
+
+    if (parser.isSet(verifyOption))
+    {
+        return verifyRecordings(parser.positionalArguments());
+    }
+
+    GameBoard board;
+    if (parser.isSet(rowsOption) || parser.isSet(colsOption) || parser.isSet(minesOption))
+    {
+        qint64 rows = 0;
+        qint64 cols = 0;
+        qint64 mines = 0;
+        if (!parseInt(parser.value(rowsOption), 2, rows)
+            || !parseInt(parser.value(colsOption), 2, cols)
+            || !parseInt(parser.value(minesOption), 0, mines)
+            || mines > rows * cols - 4)
+        {
+            qCritical("A custom size needs --rows and --cols of at least 2, and at most rows * cols - 4 --mines");
+            return 1;
+        }
+        board = GameBoard{static_cast<int>(rows), static_cast<int>(cols), static_cast<int>(mines)};
+    }
+    else
+    {
+        const QString preset = parser.value(boardOption);
+        if (preset == QLatin1String("small"))
+        {
+            board = kSmallGame;
+        }
+        else if (preset == QLatin1String("medium"))
+        {
+            board = kMediumGame;
+        }
+        else if (preset == QLatin1String("large"))
+        {
+            board = kLargeGame;
+        }
+        else
+        {
+            qCritical("Unknown board size: %s", qPrintable(preset));
+            return 1;
+        }
+    }
+
+    const QString strategyName = parser.value(strategyOption);
+    if (Strategy::create(strategyName) == nullptr)
+    {
+        qCritical("Unknown strategy: %s", qPrintable(strategyName));
+        return 1;
+    }
+
+    qint64 games = 0;
+    qint64 threads = 0;
+    bool seedOk = false;
+    const std::uint64_t seed = parser.value(seedOption).toULongLong(&seedOk);
+    if (!parseInt(parser.value(gamesOption), 1, games) || !parseInt(parser.value(threadsOption), 0, threads) || !seedOk)
+    {
+        qCritical("--games must be positive, and --threads and --seed non-negative");
+        return 1;
+    }
+
+    const Simulator simulator{board, [strategyName] { return Strategy::create(strategyName); }, static_cast<int>(threads)};
+    const Simulator::Stats stats = simulator.run(games, seed);
+
+    QTextStream out{stdout};
+    out << "board:            " << board.rows() << "x" << board.cols() << ", " << board.mines() << " mines\n"
+        << "strategy:         " << strategyName << "\n"
+        << "games:            " << stats.games << "\n"
+        << "wins:             " << stats.wins << " (" << QString::number(stats.winRate() * 100.0, 'f', 2) << "%)\n"
+        << "reveals per game: " << QString::number(stats.revealsPerGame(), 'f', 2) << "\n"
+        << "games per second: " << QString::number(stats.gamesPerSecond(), 'f', 0) << "\n";
+
+    return 0;
+}
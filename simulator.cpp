@@ -0,0 +1,153 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "simulator.h"
+#include "zobrist.h"
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Games claimed by a worker at a time: enough to keep the shared counter
+// cold, few enough that the last blocks finish together.
+constexpr qint64 kGamesPerClaim = 64;
+
+// Larger than a cache line on every target we build for, so that workers
+// counting their own games never write to the same line.
+constexpr std::size_t kCacheLine = 64;
+
+struct alignas(kCacheLine) WorkerStats
+{
+    Simulator::Stats stats;
+};
+
+} // namespace
+
+Simulator::Simulator(GameBoard board, StrategyFactory strategy, int threads)
+    : m_board{board}
+    , m_strategy{std::move(strategy)}
+    , m_threads{threads}
+{
+}
+
+bool Simulator::play(GameState state, Strategy& strategy, Rng& rng, qint64& reveals)
+{
+    Solver solver{state};
+    strategy.newGame();
+
+    while (!state.isSolved())
+    {
+        const int move = strategy.chooseMove(state, solver, rng);
+        ++reveals;
+
+        const std::vector<int> revealed = state.revealArea(move);
+        if (state.isMine(move))
+        {
+            return false;
+        }
+        solver.update(revealed);
+    }
+    return true;
+}
+
+std::uint64_t Simulator::boardSeed(std::uint64_t seed, qint64 game)
+{
+    // The splitmix64 sequence from the run's seed, indexed by game.  A seed
+    // of 0 marks a game whose mines were given explicitly, so step past it.
+    std::uint64_t state = seed + (static_cast<std::uint64_t>(game) + 1) * 0x9e3779b97f4a7c15ULL;
+    std::uint64_t result = Zobrist::mix(state);
+    while (result == 0)
+    {
+        result = Zobrist::mix(++state);
+    }
+    return result;
+}
+
+Simulator::Stats Simulator::run(qint64 games, std::uint64_t seed) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const int threads = m_threads > 0 ? m_threads : std::max(1, QThread::idealThreadCount());
+
+    const std::uint64_t runSeed = seed != 0 ? seed : Rng::randomSeed();
+
+    std::atomic<qint64> claimed{0};
+    std::vector<WorkerStats> perWorker(threads);
+
+    auto work = [&](int worker, Rng rng) {
+        Stats& stats = perWorker[worker].stats;
+        std::unique_ptr<Strategy> strategy = m_strategy();
+
+        for (;;)
+        {
+            const qint64 first = claimed.fetch_add(kGamesPerClaim, std::memory_order_relaxed);
+            if (first >= games)
+            {
+                return;
+            }
+
+            const qint64 count = std::min(kGamesPerClaim, games - first);
+            for (qint64 g = first; g < first + count; ++g)
+            {
+                ++stats.games;
+                if (play(GameState{m_board, boardSeed(runSeed, g)}, *strategy, rng, stats.reveals))
+                {
+                    ++stats.wins;
+                }
+            }
+        }
+    };
+
+    // A pool of our own, so that the workers have every core to themselves
+    // and the global pool stays free for any parallelism within a strategy.
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+
+    // Each worker draws its strategy's choices from its own stretch of one
+    // random sequence, 2^128 numbers apart from the next.  The run's seed is
+    // mixed first so that this sequence is not the boards' own.
+    Rng rng{Zobrist::mix(runSeed)};
+    std::vector<QFuture<void>> futures;
+    futures.reserve(threads);
+    for (int t = 0; t < threads; ++t)
+    {
+        futures.push_back(QtConcurrent::run(&pool, work, t, rng));
+        rng.jump();
+    }
+
+    Stats total;
+    for (int t = 0; t < threads; ++t)
+    {
+        futures[t].waitForFinished();
+        total.games += perWorker[t].stats.games;
+        total.wins += perWorker[t].stats.wins;
+        total.reveals += perWorker[t].stats.reveals;
+    }
+    total.elapsedNs = timer.nsecsElapsed();
+    return total;
+}
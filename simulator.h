@@ -0,0 +1,85 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include "gameboard.h"
+#include "strategy.h"
+
+#include <QtGlobal>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+/**
+ * @brief Plays many games of one size against a strategy, on every core,
+ *        with no UI.
+ *
+ * Each game's board comes from the run's seed and the game's index alone,
+ * so a run plays the same boards however its games fall to the workers.
+ * Each worker thread has its own strategy instance and its own random
+ * stream for the strategy's choices.  Workers claim games in small blocks
+ * from a shared counter, so none sits idle while another still has a
+ * backlog.
+ */
+class Simulator
+{
+public:
+    using StrategyFactory = std::function<std::unique_ptr<Strategy>()>;
+
+    struct Stats
+    {
+        qint64 games{};
+        qint64 wins{};
+        qint64 reveals{}; // moves made, not cells opened
+        qint64 elapsedNs{};
+
+        double winRate() const { return games > 0 ? static_cast<double>(wins) / games : 0.0; }
+        double revealsPerGame() const { return games > 0 ? static_cast<double>(reveals) / games : 0.0; }
+        double gamesPerSecond() const { return elapsedNs > 0 ? games * 1e9 / elapsedNs : 0.0; }
+    };
+
+    /**
+     * @param threads how many games to play at once; 0 for one per core.
+     */
+    Simulator(GameBoard board, StrategyFactory strategy, int threads = 0);
+
+    /**
+     * @brief Plays the given number of games.
+     * @param seed the seed from which every board and worker's stream is derived, or 0 for a random one.
+     */
+    Stats run(qint64 games, std::uint64_t seed = 0) const;
+
+    /**
+     * @brief Plays one game to the end, and returns whether it was won.
+     */
+    static bool play(GameState state, Strategy& strategy, Rng& rng, qint64& reveals);
+
+    /**
+     * @brief Returns the board seed of the given game of a run, never 0.
+     */
+    static std::uint64_t boardSeed(std::uint64_t seed, qint64 game);
+
+private:
+    GameBoard m_board;
+    StrategyFactory m_strategy;
+    int m_threads;
+};
+
+#endif // SIMULATOR_H
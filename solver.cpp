@@ -0,0 +1,249 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "solver.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+
+// Constraints are compared as bitmasks over a 7x7 window of cells centered on
+// one of them, which is large enough to hold the neighbors of any constraint
+// within two cells of the center.
+constexpr int kWindowRadius = 3;
+constexpr int kWindowSize = 2 * kWindowRadius + 1;
+
+constexpr std::uint64_t windowBit(int dx, int dy)
+{
+    return std::uint64_t{1} << ((dy + kWindowRadius) * kWindowSize + (dx + kWindowRadius));
+}
+
+} // namespace
+
+Solver::Solver(const GameState& state)
+    : m_state{state}
+{
+    reset();
+}
+
+void Solver::reset()
+{
+    m_knowledge.assign(m_state.size(), static_cast<std::uint8_t>(Knowledge::Unknown));
+    m_queued.assign(m_state.size(), 0);
+    m_queue.clear();
+    m_safe.clear();
+    m_mines.clear();
+
+    for (int ix = 0; ix < m_state.size(); ++ix)
+    {
+        if (m_state.isRevealed(ix) && !m_state.isMine(ix) && m_state.neighboringMines(ix) != 0)
+        {
+            m_queued[ix] = 1;
+            m_queue.push_back(ix);
+        }
+    }
+
+    drain();
+}
+
+void Solver::update(const std::vector<int>& changedCells)
+{
+    for (int ix : changedCells)
+    {
+        enqueueAround(ix);
+    }
+
+    drain();
+
+    std::erase_if(m_safe, [this](int ix) { return m_state.isRevealed(ix); });
+}
+
+std::vector<int> Solver::safeCells() const
+{
+    std::vector<int> cells;
+    std::copy_if(m_safe.begin(), m_safe.end(), std::back_inserter(cells), [this](int ix) {
+        return !m_state.isRevealed(ix);
+    });
+    return cells;
+}
+
+std::vector<int> Solver::mineCells() const
+{
+    std::vector<int> cells;
+    std::copy_if(m_mines.begin(), m_mines.end(), std::back_inserter(cells), [this](int ix) {
+        return !m_state.isRevealed(ix);
+    });
+    return cells;
+}
+
+void Solver::enqueueAround(int index)
+{
+    auto enqueue = [this](int ix) {
+        if (!m_queued[ix] && m_state.isRevealed(ix) && !m_state.isMine(ix))
+        {
+            m_queued[ix] = 1;
+            m_queue.push_back(ix);
+        }
+    };
+
+    enqueue(index);
+    m_state.forEachNeighbor(index, enqueue);
+}
+
+void Solver::drain()
+{
+    while (!m_queue.empty())
+    {
+        const int ix = m_queue.back();
+        m_queue.pop_back();
+        m_queued[ix] = 0;
+
+        examine(ix);
+    }
+}
+
+void Solver::examine(int index)
+{
+    const int cols = m_state.cols();
+    const int rows = m_state.rows();
+    const int ax = index % cols;
+    const int ay = index / cols;
+
+    std::uint64_t a = 0;
+    int aMines = 0;
+    if (!constraintAt(index, ax, ay, a, aMines) || a == 0)
+    {
+        return;
+    }
+
+    deduce(a, aMines, ax, ay);
+
+    // Every statement compared here ("these cells hold this many mines") was
+    // true when it was computed, so deductions from them stay sound even as
+    // earlier deductions in this loop resolve some of the cells involved.
+    for (int dy = -2; dy <= 2; ++dy)
+    {
+        for (int dx = -2; dx <= 2; ++dx)
+        {
+            const int bx = ax + dx;
+            const int by = ay + dy;
+            if ((dx == 0 && dy == 0) || bx < 0 || bx >= cols || by < 0 || by >= rows)
+            {
+                continue;
+            }
+
+            std::uint64_t b = 0;
+            int bMines = 0;
+            if (!constraintAt(by * cols + bx, ax, ay, b, bMines) || b == 0 || b == a)
+            {
+                continue;
+            }
+
+            if ((a & b) == a)
+            {
+                deduce(b & ~a, bMines - aMines, ax, ay);
+            }
+            else if ((a & b) == b)
+            {
+                deduce(a & ~b, aMines - bMines, ax, ay);
+            }
+        }
+    }
+}
+
+bool Solver::constraintAt(int index, int centerX, int centerY, std::uint64_t& cells, int& mines) const
+{
+    if (!m_state.isRevealed(index) || m_state.isMine(index))
+    {
+        return false;
+    }
+
+    const int cols = m_state.cols();
+
+    cells = 0;
+    mines = m_state.neighboringMines(index);
+
+    m_state.forEachNeighbor(index, [&](int n) {
+        if (m_state.isRevealed(n))
+        {
+            // Only possible once the game is lost, but count it all the same.
+            mines -= m_state.isMine(n) ? 1 : 0;
+            return;
+        }
+
+        switch (knowledge(n))
+        {
+        case Knowledge::Mine:
+            --mines;
+            break;
+        case Knowledge::Safe:
+            break;
+        case Knowledge::Unknown:
+            cells |= windowBit(n % cols - centerX, n / cols - centerY);
+            break;
+        }
+    });
+
+    return true;
+}
+
+void Solver::deduce(std::uint64_t cells, int mines, int centerX, int centerY)
+{
+    if (cells == 0)
+    {
+        return;
+    }
+
+    Knowledge knowledge;
+    if (mines == 0)
+    {
+        knowledge = Knowledge::Safe;
+    }
+    else if (mines == std::popcount(cells))
+    {
+        knowledge = Knowledge::Mine;
+    }
+    else
+    {
+        return;
+    }
+
+    const int cols = m_state.cols();
+    while (cells != 0)
+    {
+        const int bit = std::countr_zero(cells);
+        cells &= cells - 1;
+
+        const int x = centerX + bit % kWindowSize - kWindowRadius;
+        const int y = centerY + bit / kWindowSize - kWindowRadius;
+        learn(y * cols + x, knowledge);
+    }
+}
+
+void Solver::learn(int index, Knowledge knowledge)
+{
+    if (m_state.isRevealed(index) || m_knowledge[index] != static_cast<std::uint8_t>(Knowledge::Unknown))
+    {
+        return;
+    }
+
+    m_knowledge[index] = static_cast<std::uint8_t>(knowledge);
+    (knowledge == Knowledge::Safe ? m_safe : m_mines).push_back(index);
+
+    enqueueAround(index);
+}
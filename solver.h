@@ -0,0 +1,100 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "gamestate.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Deduces which unrevealed cells are certainly safe or certainly mines,
+ *        using only what the player can see.
+ *
+ * Every revealed number is a constraint: its unknown neighbors hold exactly
+ * as many mines as the number, less the neighbors already known to be mines.
+ * Two rules are applied until nothing more follows:
+ *
+ *   - single point: a constraint needing no more mines makes all its unknown
+ *     neighbors safe, and one needing as many mines as it has unknown
+ *     neighbors makes them all mines;
+ *   - subset: if one constraint's unknown cells are a subset of another's,
+ *     the difference holds the difference in mines, to which the single
+ *     point rule is then applied.
+ *
+ * The solver is incremental: update() re-examines only the constraints
+ * around the cells that changed, and whatever those deductions touch.
+ *
+ * The player's flags are not trusted; only revealed cells are used.
+ */
+class Solver
+{
+public:
+    enum class Knowledge : std::uint8_t
+    {
+        Unknown,
+        Safe,
+        Mine,
+    };
+
+    /**
+     * @brief Creates a solver over the given state, and solves it as it stands.
+     *        The state must outlive the solver.
+     */
+    explicit Solver(const GameState& state);
+
+    /**
+     * @brief Accounts for cells that have been revealed since the last update.
+     */
+    void update(const std::vector<int>& changedCells);
+
+    /**
+     * @brief Forgets every deduction and solves the state from scratch.
+     */
+    void reset();
+
+    Knowledge knowledge(int index) const { return static_cast<Knowledge>(m_knowledge[index]); }
+
+    /**
+     * @brief Unrevealed cells that cannot be mines.
+     */
+    std::vector<int> safeCells() const;
+
+    /**
+     * @brief Unrevealed cells that must be mines.
+     */
+    std::vector<int> mineCells() const;
+
+private:
+    void enqueueAround(int index);
+    void drain();
+    void examine(int index);
+    bool constraintAt(int index, int centerX, int centerY, std::uint64_t& cells, int& mines) const;
+    void deduce(std::uint64_t cells, int mines, int centerX, int centerY);
+    void learn(int index, Knowledge knowledge);
+
+    const GameState& m_state;
+    std::vector<std::uint8_t> m_knowledge;
+    std::vector<std::uint8_t> m_queued;
+    std::vector<int> m_queue;
+    std::vector<int> m_safe;
+    std::vector<int> m_mines;
+};
+
+#endif // SOLVER_H
@@ -0,0 +1,111 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "statsdialog.h"
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QVBoxLayout>
+
+namespace {
+
+QString boardName(const GameBoard& board)
+{
+    if (board == kSmallGame)
+    {
+        return StatsDialog::tr("Small");
+    }
+    if (board == kMediumGame)
+    {
+        return StatsDialog::tr("Medium");
+    }
+    if (board == kLargeGame)
+    {
+        return StatsDialog::tr("Large");
+    }
+    return StatsDialog::tr("%1x%2, %3 mines").arg(board.rows()).arg(board.cols()).arg(board.mines());
+}
+
+QTableWidgetItem* item(const QString& text)
+{
+    QTableWidgetItem* item = new QTableWidgetItem(text);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+} // namespace
+
+StatsDialog::StatsDialog(const StatsLog& log, QWidget* parent)
+    : QDialog::QDialog(parent)
+    , m_log{log}
+{
+    setWindowTitle(tr("Statistics"));
+
+    m_table = new QTableWidget(this);
+    m_table->setColumnCount(6);
+    m_table->setHorizontalHeaderLabels({tr("Played"), tr("Won"), tr("Win Rate"), tr("Best Time"), tr("Streak"), tr("Longest Streak")});
+    m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_table->setSelectionMode(QAbstractItemView::NoSelection);
+
+    QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Close, Qt::Horizontal, this);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+
+    QVBoxLayout* vbox = new QVBoxLayout;
+    vbox->addWidget(m_table);
+    vbox->addWidget(buttons);
+
+    setLayout(vbox);
+}
+
+void StatsDialog::showEvent(QShowEvent* event)
+{
+    refresh();
+    QDialog::showEvent(event);
+}
+
+void StatsDialog::refresh()
+{
+    const std::map<GameBoard, StatsLog::BoardStats>& all = m_log.allStats();
+
+    m_table->setRowCount(static_cast<int>(all.size()));
+
+    int row = 0;
+    for (const auto& [board, stats] : all)
+    {
+        m_table->setVerticalHeaderItem(row, new QTableWidgetItem(boardName(board)));
+        m_table->setItem(row, 0, item(QString::number(stats.played)));
+        m_table->setItem(row, 1, item(QString::number(stats.won)));
+        m_table->setItem(row, 2, item(QStringLiteral("%1%").arg(stats.winRate() * 100.0, 0, 'f', 1)));
+        m_table->setItem(row, 3, item(stats.bestTimeUs >= 0 ? tr("%1 s").arg(stats.bestTimeUs / 1e6, 0, 'f', 3) : QStringLiteral("-")));
+        m_table->setItem(row, 4, item(QString::number(stats.streak)));
+        m_table->setItem(row, 5, item(QString::number(stats.longestStreak)));
+        ++row;
+    }
+
+    if (all.empty())
+    {
+        m_table->setRowCount(1);
+        m_table->setVerticalHeaderItem(0, new QTableWidgetItem(QString{}));
+        m_table->setSpan(0, 0, 1, m_table->columnCount());
+        m_table->setItem(0, 0, new QTableWidgetItem(tr("No games finished yet")));
+    }
+    else
+    {
+        m_table->clearSpans();
+    }
+}
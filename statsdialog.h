@@ -0,0 +1,51 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STATSDIALOG_H
+#define STATSDIALOG_H
+
+#include "statslog.h"
+
+#include <QDialog>
+#include <QShowEvent>
+#include <QTableWidget>
+
+/**
+ * @brief Shows the totals for every board size played.
+ *
+ * The table is refilled from the log's running totals each time the dialog
+ * is shown, which takes one row per board size, however many games there
+ * have been.
+ */
+class StatsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit StatsDialog(const StatsLog& log, QWidget* parent = nullptr);
+
+protected:
+    void showEvent(QShowEvent* event) override;
+
+private:
+    void refresh();
+
+    const StatsLog& m_log;
+    QTableWidget* m_table;
+};
+
+#endif // STATSDIALOG_H
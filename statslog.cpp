@@ -0,0 +1,219 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "statslog.h"
+
+#include <QFile>
+#include <QtConcurrent>
+#include <QtEndian>
+
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+constexpr char kMagic[4] = {'M', 'N', 'S', 'T'};
+
+QByteArray header()
+{
+    QByteArray bytes(StatsLog::kHeaderSize, '\0');
+    std::copy(std::begin(kMagic), std::end(kMagic), bytes.begin());
+    qToLittleEndian<quint16>(StatsLog::kVersion, bytes.data() + 4);
+    return bytes;
+}
+
+} // namespace
+
+StatsLog::StatsLog(QString path, QThreadPool* pool)
+    : m_path{std::move(path)}
+    , m_pool{pool != nullptr ? pool : QThreadPool::globalInstance()}
+    , m_usable{true}
+    , m_writing{false}
+{
+}
+
+StatsLog::~StatsLog()
+{
+    flush();
+}
+
+bool StatsLog::load()
+{
+    QFile file{m_path};
+    if (!file.exists())
+    {
+        return true;
+    }
+
+    if (!file.open(QIODevice::ReadWrite))
+    {
+        m_usable = false;
+        return false;
+    }
+
+    const qint64 size = file.size();
+    if (size == 0)
+    {
+        return true;
+    }
+
+    const uchar* mapped = size >= kHeaderSize ? file.map(0, size) : nullptr;
+    if (mapped == nullptr
+        || !std::equal(std::begin(kMagic), std::end(kMagic), mapped)
+        || qFromLittleEndian<quint16>(mapped + 4) != kVersion)
+    {
+        m_usable = false;
+        return false;
+    }
+
+    const qint64 records = (size - kHeaderSize) / kRecordSize;
+    for (qint64 ix = 0; ix < records; ++ix)
+    {
+        add(decode(QByteArrayView{mapped + kHeaderSize + ix * kRecordSize, kRecordSize}));
+    }
+    file.unmap(const_cast<uchar*>(mapped));
+
+    // A record cut short by a crash would misalign every one after it.
+    const qint64 valid = kHeaderSize + records * kRecordSize;
+    if (valid != size)
+    {
+        file.resize(valid);
+    }
+    return true;
+}
+
+void StatsLog::append(const Game& game)
+{
+    add(game);
+
+    if (!m_usable)
+    {
+        return;
+    }
+
+    std::lock_guard lock{m_mutex};
+    m_pending.append(encode(game));
+    if (!m_writing)
+    {
+        m_writing = true;
+        m_writer = QtConcurrent::run(m_pool, [this]() { writePending(); });
+    }
+}
+
+void StatsLog::flush()
+{
+    QFuture<void> writer;
+    {
+        std::lock_guard lock{m_mutex};
+        writer = m_writer;
+    }
+    writer.waitForFinished();
+}
+
+StatsLog::BoardStats StatsLog::stats(const GameBoard& board) const
+{
+    const auto it = m_stats.find(board);
+    return it != m_stats.end() ? it->second : BoardStats{};
+}
+
+void StatsLog::add(const Game& game)
+{
+    BoardStats& stats = m_stats[game.board];
+
+    ++stats.played;
+    if (game.won)
+    {
+        ++stats.won;
+        ++stats.streak;
+        stats.longestStreak = std::max(stats.longestStreak, stats.streak);
+        if (stats.bestTimeUs < 0 || game.timeUs < stats.bestTimeUs)
+        {
+            stats.bestTimeUs = game.timeUs;
+        }
+    }
+    else
+    {
+        stats.streak = 0;
+    }
+}
+
+void StatsLog::writePending()
+{
+    for (;;)
+    {
+        QByteArray batch;
+        {
+            std::lock_guard lock{m_mutex};
+            if (m_pending.isEmpty())
+            {
+                m_writing = false;
+                return;
+            }
+            batch.swap(m_pending);
+        }
+
+        QFile file{m_path};
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+        {
+            qWarning("Couldn't open the statistics log %s: %s", qPrintable(m_path), qPrintable(file.errorString()));
+            continue;
+        }
+
+        if (file.size() == 0)
+        {
+            batch.prepend(header());
+        }
+
+        if (file.write(batch) != batch.size())
+        {
+            qWarning("Couldn't write to the statistics log %s: %s", qPrintable(m_path), qPrintable(file.errorString()));
+        }
+    }
+}
+
+QByteArray StatsLog::encode(const Game& game)
+{
+    QByteArray bytes(kRecordSize, '\0');
+    char* data = bytes.data();
+
+    qToLittleEndian<qint32>(game.board.rows(), data);
+    qToLittleEndian<qint32>(game.board.cols(), data + 4);
+    qToLittleEndian<qint32>(game.board.mines(), data + 8);
+    data[12] = game.won ? 1 : 0;
+    qToLittleEndian<quint64>(game.seed, data + 16);
+    qToLittleEndian<qint64>(game.timeUs, data + 24);
+    qToLittleEndian<qint32>(game.moves, data + 32);
+    qToLittleEndian<qint32>(game.threeBV, data + 36);
+    qToLittleEndian<qint64>(game.finishedAtMs, data + 40);
+    return bytes;
+}
+
+StatsLog::Game StatsLog::decode(QByteArrayView record)
+{
+    Q_ASSERT(record.size() == kRecordSize);
+    const char* data = record.data();
+
+    Game game;
+    game.board = GameBoard{qFromLittleEndian<qint32>(data), qFromLittleEndian<qint32>(data + 4), qFromLittleEndian<qint32>(data + 8)};
+    game.won = data[12] != 0;
+    game.seed = qFromLittleEndian<quint64>(data + 16);
+    game.timeUs = qFromLittleEndian<qint64>(data + 24);
+    game.moves = qFromLittleEndian<qint32>(data + 32);
+    game.threeBV = qFromLittleEndian<qint32>(data + 36);
+    game.finishedAtMs = qFromLittleEndian<qint64>(data + 40);
+    return game;
+}
@@ -0,0 +1,157 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STATSLOG_H
+#define STATSLOG_H
+
+#include "gameboard.h"
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFuture>
+#include <QString>
+#include <QThreadPool>
+#include <QtGlobal>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/**
+ * @brief Every finished game, in an append-only file, with running totals
+ *        per board kept in memory.
+ *
+ * The file is an 8-byte header, "MNST" and a 2-byte version and 2 reserved
+ * bytes, followed by one fixed-size, little-endian record per game:
+ *
+ *   offset  size  field
+ *        0     4  rows
+ *        4     4  columns
+ *        8     4  mines
+ *       12     1  1 if won, 0 if lost
+ *       13     3  reserved, 0
+ *       16     8  seed, or 0 if the mines were given explicitly
+ *       24     8  microseconds played
+ *       32     4  moves made
+ *       36     4  3BV
+ *       40     8  when the game ended, in milliseconds since the epoch
+ *
+ * Records are only ever added at the end, so a crash can at worst leave a
+ * partial record there, which load() cuts off.
+ *
+ * The totals are read once, by load(), and kept up to date by append(), so
+ * asking for them costs nothing however many games have been played.
+ * Appends reach the file on a background thread: records that arrive while
+ * a write is under way are batched into the next one.
+ */
+class StatsLog
+{
+public:
+    static constexpr quint16 kVersion = 1;
+    static constexpr qsizetype kHeaderSize = 8;
+    static constexpr qsizetype kRecordSize = 48;
+
+    struct Game
+    {
+        GameBoard board;
+        std::uint64_t seed{};
+        bool won{};
+        qint64 timeUs{};
+        int moves{};
+        int threeBV{};
+        qint64 finishedAtMs{};
+
+        bool operator==(const Game&) const = default;
+    };
+
+    struct BoardStats
+    {
+        qint64 played{};
+        qint64 won{};
+        qint64 bestTimeUs{-1}; // of a win; -1 if there are none
+        qint64 streak{};       // wins since the last loss
+        qint64 longestStreak{};
+
+        double winRate() const { return played > 0 ? static_cast<double>(won) / played : 0.0; }
+    };
+
+    /**
+     * @param pool where writes are made; by default the global pool.
+     */
+    explicit StatsLog(QString path, QThreadPool* pool = nullptr);
+
+    /**
+     * @brief Waits for every write still pending.
+     */
+    ~StatsLog();
+
+    StatsLog(const StatsLog&) = delete;
+    StatsLog& operator=(const StatsLog&) = delete;
+
+    /**
+     * @brief Reads the whole log to build the totals.  Call once, before
+     *        anything else; it may run on any thread.
+     *
+     * A missing file is an empty log.  Returns false if the file is not a
+     * log this version can read, in which case the log stays empty and
+     * append() won't touch the file.
+     */
+    bool load();
+
+    /**
+     * @brief Adds a finished game to the totals at once, and to the file
+     *        in the background.
+     */
+    void append(const Game& game);
+
+    /**
+     * @brief Blocks until every game appended so far is in the file.
+     */
+    void flush();
+
+    /**
+     * @brief The totals for one board size, which are all zero if no game
+     *        of that size has been played.
+     */
+    BoardStats stats(const GameBoard& board) const;
+
+    /**
+     * @brief The totals for every board size played, smallest first.
+     */
+    const std::map<GameBoard, BoardStats>& allStats() const { return m_stats; }
+
+    static QByteArray encode(const Game& game);
+    static Game decode(QByteArrayView record);
+
+private:
+    void add(const Game& game);
+    void writePending();
+
+    QString m_path;
+    QThreadPool* m_pool;
+    std::map<GameBoard, BoardStats> m_stats;
+    bool m_usable;
+
+    std::mutex m_mutex; // guards everything below
+    QByteArray m_pending;
+    bool m_writing;
+    QFuture<void> m_writer;
+};
+
+#endif // STATSLOG_H
@@ -0,0 +1,184 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "strategy.h"
+
+#include "constraintproblem.h"
+#include "probability.h"
+
+#include <vector>
+
+namespace {
+
+class RandomStrategy : public Strategy
+{
+public:
+    int chooseMove(const GameState& state, const Solver& solver, Rng& rng) override
+    {
+        Q_UNUSED(solver);
+
+        std::vector<int> unrevealed;
+        for (int ix = 0; ix < state.size(); ++ix)
+        {
+            if (!state.isRevealed(ix))
+            {
+                unrevealed.push_back(ix);
+            }
+        }
+        return unrevealed[rng.bounded(static_cast<std::uint32_t>(unrevealed.size()))];
+    }
+};
+
+// Opens in a corner, which is never a mine, then plays whatever the solver
+// proves safe, and leaves guessing to subclasses.
+class SolverStrategy : public Strategy
+{
+public:
+    void newGame() override
+    {
+        m_opened = false;
+    }
+
+    int chooseMove(const GameState& state, const Solver& solver, Rng& rng) override
+    {
+        if (!m_opened)
+        {
+            m_opened = true;
+            return 0;
+        }
+
+        const std::vector<int> safe = solver.safeCells();
+        if (!safe.empty())
+        {
+            return safe.front();
+        }
+
+        return guess(state, solver, rng);
+    }
+
+protected:
+    // Picks uniformly among the cells the solver knows nothing about.
+    virtual int guess(const GameState& state, const Solver& solver, Rng& rng)
+    {
+        const ConstraintProblem problem = ConstraintProblem::fromState(state, &solver);
+
+        std::uint32_t unknown = static_cast<std::uint32_t>(problem.interior.size());
+        for (const ConstraintProblem::Component& component : problem.components)
+        {
+            unknown += static_cast<std::uint32_t>(component.cells.size());
+        }
+
+        std::uint32_t pick = rng.bounded(unknown);
+        for (const ConstraintProblem::Component& component : problem.components)
+        {
+            if (pick < component.cells.size())
+            {
+                return component.cells[pick];
+            }
+            pick -= static_cast<std::uint32_t>(component.cells.size());
+        }
+        return problem.interior[pick];
+    }
+
+private:
+    bool m_opened{false};
+};
+
+class ProbabilityStrategy : public SolverStrategy
+{
+protected:
+    // Picks the unknown cell least likely to be a mine, breaking ties
+    // uniformly.  Where the engine couldn't enumerate a component, it gives
+    // its cells the interior probability, which is still a fair guess.
+    //
+    // The unknown cells are those of the problem's components and its
+    // interior, so only the frontier is visited one cell at a time; the
+    // interior cells all share one probability and are weighed together.
+    int guess(const GameState& state, const Solver& solver, Rng& rng) override
+    {
+        const ConstraintProblem problem = ConstraintProblem::fromState(state, &solver);
+        const ProbabilityEngine::Result result = m_engine.compute(state, problem);
+
+        int best = -1;
+        double bestProbability = 2.0;
+        std::uint32_t ties = 0;
+        for (const ConstraintProblem::Component& component : problem.components)
+        {
+            for (int ix : component.cells)
+            {
+                const double p = result.mineProbability[ix];
+                if (p < bestProbability)
+                {
+                    best = ix;
+                    bestProbability = p;
+                    ties = 1;
+                }
+                else if (p == bestProbability && rng.bounded(++ties) == 0)
+                {
+                    best = ix;
+                }
+            }
+        }
+
+        if (!problem.interior.empty())
+        {
+            const std::uint32_t interiorCells = static_cast<std::uint32_t>(problem.interior.size());
+            const double p = result.mineProbability[problem.interior.front()];
+            if (p < bestProbability)
+            {
+                best = problem.interior[rng.bounded(interiorCells)];
+            }
+            else if (p == bestProbability)
+            {
+                ties += interiorCells;
+                const std::uint32_t pick = rng.bounded(ties);
+                if (pick < interiorCells)
+                {
+                    best = problem.interior[pick];
+                }
+            }
+        }
+        return best;
+    }
+
+private:
+    ProbabilityEngine m_engine;
+};
+
+} // namespace
+
+QStringList Strategy::names()
+{
+    return {QStringLiteral("random"), QStringLiteral("solver"), QStringLiteral("probability")};
+}
+
+std::unique_ptr<Strategy> Strategy::create(const QString& name)
+{
+    if (name == QLatin1String("random"))
+    {
+        return std::make_unique<RandomStrategy>();
+    }
+    if (name == QLatin1String("solver"))
+    {
+        return std::make_unique<SolverStrategy>();
+    }
+    if (name == QLatin1String("probability"))
+    {
+        return std::make_unique<ProbabilityStrategy>();
+    }
+    return nullptr;
+}
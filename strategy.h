@@ -0,0 +1,72 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef STRATEGY_H
+#define STRATEGY_H
+
+#include "gamestate.h"
+#include "rng.h"
+#include "solver.h"
+
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+
+/**
+ * @brief A way of playing: given what is visible, picks the next cell to reveal.
+ *
+ * A strategy may keep state between moves of one game, so each thread
+ * playing games needs an instance of its own; see create().
+ */
+class Strategy
+{
+public:
+    virtual ~Strategy() = default;
+
+    /**
+     * @brief Called before the first move of every game.
+     */
+    virtual void newGame() {}
+
+    /**
+     * @brief Chooses the next cell to reveal in a game still in progress.
+     *
+     * The solver is up to date with every cell revealed so far.  Any
+     * randomness must come from the given generator, so that runs are
+     * reproducible.
+     */
+    virtual int chooseMove(const GameState& state, const Solver& solver, Rng& rng) = 0;
+
+    /**
+     * @brief The names accepted by create().
+     */
+    static QStringList names();
+
+    /**
+     * @brief Creates the named strategy, or returns null if there is none by that name.
+     *
+     *   - "random": any unrevealed cell, uniformly;
+     *   - "solver": a corner first, then cells the solver proves safe,
+     *     guessing uniformly among the unknown cells when it has none;
+     *   - "probability": as "solver", but guessing the cell least likely
+     *     to be a mine.
+     */
+    static std::unique_ptr<Strategy> create(const QString& name);
+};
+
+#endif // STRATEGY_H
@@ -0,0 +1,153 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+// Checks countNeighboringMines() against the definition, a cell at a time.
+//
+// The kernel picks its instruction set when it is compiled, so the build
+// compiles this test once for each of the scalar, SSE2 and AVX2 paths; see
+// MINES_BUILD_TESTS in CMakeLists.txt.
+
+#include "neighborcount.h"
+
+#include <QObject>
+#include <QTest>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<std::uint8_t> naiveCounts(const std::vector<std::uint8_t>& mines, int rows, int cols)
+{
+    std::vector<std::uint8_t> counts(mines.size());
+    for (int y = 0; y < rows; ++y)
+    {
+        for (int x = 0; x < cols; ++x)
+        {
+            int count = 0;
+            for (int dy = -1; dy <= 1; ++dy)
+            {
+                for (int dx = -1; dx <= 1; ++dx)
+                {
+                    const int nx = x + dx;
+                    const int ny = y + dy;
+                    if ((dx != 0 || dy != 0) && nx >= 0 && nx < cols && ny >= 0 && ny < rows)
+                    {
+                        count += mines[ny * cols + nx];
+                    }
+                }
+            }
+            counts[y * cols + x] = static_cast<std::uint8_t>(count);
+        }
+    }
+    return counts;
+}
+
+} // namespace
+
+class NeighborCountTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void matchesDefinition_data();
+    void matchesDefinition();
+};
+
+void NeighborCountTest::initTestCase()
+{
+#if defined(MINES_FORCE_SCALAR)
+    qInfo("Checking the scalar path");
+#elif defined(__AVX2__)
+#if defined(__GNUC__)
+    if (!__builtin_cpu_supports("avx2"))
+    {
+        QSKIP("This CPU doesn't support AVX2");
+    }
+#endif
+    qInfo("Checking the AVX2 path");
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    qInfo("Checking the SSE2 path");
+#else
+    qInfo("Checking the scalar path; this target has no SSE2");
+#endif
+}
+
+void NeighborCountTest::matchesDefinition_data()
+{
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("cols");
+
+    // Single cells, single rows and columns, and widths on either side of
+    // each vector width, so that every path meets its scalar tail.
+    const int sizes[][2] = {
+        {1, 1}, {1, 2}, {2, 1}, {1, 37}, {37, 1}, {1, 64}, {64, 1},
+        {2, 2}, {3, 3}, {5, 7}, {7, 5},
+        {9, 15}, {9, 16}, {9, 17}, {11, 31}, {11, 32}, {11, 33},
+        {13, 47}, {13, 63}, {13, 64}, {13, 65}, {16, 30}, {75, 75}, {101, 99},
+    };
+    for (const auto& [rows, cols] : sizes)
+    {
+        QTest::addRow("%dx%d", rows, cols) << rows << cols;
+    }
+}
+
+void NeighborCountTest::matchesDefinition()
+{
+    QFETCH(int, rows);
+    QFETCH(int, cols);
+
+    std::mt19937 random{static_cast<std::uint32_t>(rows * 1000 + cols)};
+    const size_t cells = static_cast<size_t>(rows) * cols;
+
+    // Empty, full, and a spread of densities in between.
+    for (int density : {0, 10, 25, 50, 75, 100})
+    {
+        for (int trial = 0; trial < 8; ++trial)
+        {
+            std::vector<std::uint8_t> mines(cells);
+            for (std::uint8_t& mine : mines)
+            {
+                mine = static_cast<int>(random() % 100) < density ? 1 : 0;
+            }
+
+            std::vector<std::uint8_t> counts(cells, 0xFF);
+            countNeighboringMines(mines.data(), counts.data(), rows, cols);
+
+            const std::vector<std::uint8_t> expected = naiveCounts(mines, rows, cols);
+            for (size_t ix = 0; ix < cells; ++ix)
+            {
+                if (counts[ix] != expected[ix])
+                {
+                    QFAIL(qPrintable(QStringLiteral("At density %1%, cell (%2, %3) has %4 neighboring mines, not %5")
+                                         .arg(density)
+                                         .arg(ix % cols)
+                                         .arg(ix / cols)
+                                         .arg(counts[ix])
+                                         .arg(expected[ix])));
+                }
+            }
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(NeighborCountTest)
+
+#include "neighborcounttest.moc"
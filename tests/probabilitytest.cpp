@@ -0,0 +1,93 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+// Checks ProbabilityEngine's exact counts where the answer is known.
+
+#include "probability.h"
+
+#include <QObject>
+#include <QTest>
+
+#include <cmath>
+#include <vector>
+
+class ProbabilityTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void longStrip_data();
+    void longStrip();
+};
+
+void ProbabilityTest::longStrip_data()
+{
+    QTest::addColumn<int>("length");
+
+    // A strip of n columns has 2^n configurations, past the range of a
+    // double from 1024 columns on.
+    for (int length : {2, 10, 500, 1100, 1600})
+    {
+        QTest::addRow("%d columns", length) << length;
+    }
+}
+
+void ProbabilityTest::longStrip()
+{
+    QFETCH(int, length);
+
+    // Three rows, with the middle one revealed and one mine above or below
+    // each of its cells.  Its numbers then allow exactly one mine in every
+    // column, in either row, so each hidden cell is a mine with probability
+    // one half.
+    std::vector<int> mines;
+    for (int x = 0; x < length; ++x)
+    {
+        mines.push_back(x % 2 == 0 ? 2 * length + x : x);
+    }
+
+    GameState state{GameBoard{3, length, length}, mines};
+    for (int x = 0; x < length; ++x)
+    {
+        state.reveal(length + x);
+    }
+
+    // Every hidden cell is on the frontier, in one component, which needs
+    // more than the default memory to enumerate.
+    const ProbabilityEngine engine{qsizetype{1} << 30};
+    const ProbabilityEngine::Result result = engine.compute(state);
+
+    QVERIFY(result.exact);
+    QCOMPARE(result.components.size(), size_t{1});
+    for (int ix = 0; ix < state.size(); ++ix)
+    {
+        const double expected = state.isRevealed(ix) ? 0.0 : 0.5;
+        if (std::isnan(result.mineProbability[ix]) || std::abs(result.mineProbability[ix] - expected) > 1e-9)
+        {
+            QFAIL(qPrintable(QStringLiteral("Cell (%1, %2) is a mine with probability %3, not %4")
+                                 .arg(ix % length)
+                                 .arg(ix / length)
+                                 .arg(result.mineProbability[ix])
+                                 .arg(expected)));
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(ProbabilityTest)
+
+#include "probabilitytest.moc"
@@ -15,15 +15,17 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
-#include "cell.h"
+#include "tileatlas.h"
 
 #include <QBrush>
-#include <QFontMetrics>
 #include <QColor>
+#include <QFontMetrics>
 #include <QPainter>
 #include <QPainterPath>
+#include <QString>
+#include <QSvgRenderer>
 
-#include <array>
+#include <cmath>
 
 namespace Brushes
 {
@@ -32,7 +34,6 @@ QBrush DarkerBackground(Qt::darkGray);
 QBrush DarkBackground(Qt::gray);
 QBrush Background(Qt::lightGray);
 QBrush Highlight(Qt::white);
-QBrush Test(Qt::red);
 
 const auto labelColors = std::array {
     Qt::red, // zero value should never be used
@@ -48,117 +49,37 @@ const auto labelColors = std::array {
 
 } // namespace Brushes
 
-Cell::Cell(QPoint coords, QWidget *parent)
-    : QPushButton{parent}
-    , m_revealed(false)
-    , m_flagged(false)
-    , m_gameOver(false)
-    , m_leftMouseDown(false)
-    , m_rightMouseDown(false)
-    , m_coords(coords)
-    , m_numNeighboringMines(0)
-{
-    // For some dumb reason on macOS, cells in a grid layout have vertical overlap, a little bit,
-    // unless you set this attribute.
-    setAttribute(Qt::WA_LayoutUsesWidgetRect);
-}
-
-void Cell::setNumNeighboringMines(int numNeighboringMines)
-{
-    Q_ASSERT(numNeighboringMines >= -1);
-    Q_ASSERT(numNeighboringMines <= 9);
-    m_numNeighboringMines = numNeighboringMines;
-}
-
-void Cell::toggleFlag()
+void TileAtlas::prepare(QSize cellSize, qreal devicePixelRatio, const QFont& font)
 {
-    if (m_revealed)
+    if (cellSize == m_cellSize && devicePixelRatio == m_devicePixelRatio && font == m_font)
     {
         return;
     }
 
-    m_flagged = !m_flagged;
-    update();
-}
-
-void Cell::reveal()
-{
-    if (m_revealed)
-    {
-        return;
-    }
-    m_revealed = true;
+    m_cellSize = cellSize;
+    m_devicePixelRatio = devicePixelRatio;
+    m_font = font;
 
-    emit revealed(m_coords);
-
-    update();
+    render();
 }
 
-void Cell::gameEnded()
+void TileAtlas::render()
 {
-    if (m_gameOver)
+    for (int tile = 0; tile < TileCount; ++tile)
     {
-        return;
+        renderTile(static_cast<Tile>(tile));
     }
-    m_gameOver = true;
-
-    update();
 }
 
-void Cell::mouseMoveEvent(QMouseEvent* event)
+void TileAtlas::renderTile(Tile tile)
 {
-    event->ignore();
-}
+    QPixmap pixmap{m_cellSize * m_devicePixelRatio};
+    pixmap.setDevicePixelRatio(m_devicePixelRatio);
 
-void Cell::mousePressEvent(QMouseEvent* event)
-{
-    if (event->button() == Qt::RightButton)
-    {
-        m_rightMouseDown = true;
-    }
-    else if (event->button() == Qt::LeftButton)
-    {
-        m_leftMouseDown = true;
-    }
-
-    QPushButton::mousePressEvent(event);
-}
+    QPainter painter(&pixmap);
+    painter.setFont(m_font);
 
-void Cell::mouseReleaseEvent(QMouseEvent* event)
-{
-    auto pos = event->pos();
-    auto rect = this->rect();
-    bool releasedInThisCell = rect.contains(pos, true);
-
-    if (event->button() == Qt::RightButton)
-    {
-        m_rightMouseDown = false;
-
-        if (releasedInThisCell)
-        {
-            toggleFlag();
-            event->accept();
-        }
-    }
-    else if (event->button() == Qt::LeftButton)
-    {
-        m_leftMouseDown = false;
-
-        if (releasedInThisCell)
-        {
-            reveal();
-            event->accept();
-        }
-    }
-
-    QPushButton::mouseReleaseEvent(event);
-}
-
-void Cell::paintEvent(QPaintEvent* event)
-{
-    QPainter painter(this);
-
-    const QRectF rect = event->rect().toRectF();
+    const QRectF rect{QPointF{0, 0}, m_cellSize.toSizeF()};
 
     double dy = rect.height() * 0.1;
     double dx = rect.width() * 0.1;
@@ -176,20 +97,22 @@ void Cell::paintEvent(QPaintEvent* event)
     QRectF mineRect{topLeftIn, bottomRightIn};
 
     QString label;
-    if (m_revealed)
+    bool drawMine = false;
+
+    if (tile == ExplodedMine || tile >= Revealed)
     {
         painter.fillRect(rect, Brushes::Background);
 
-        if (isMine())
+        if (tile == ExplodedMine)
         {
             painter.fillRect(rect, Qt::red);
-            painter.setPen(Qt::black);
-            painter.drawImage(mineRect, QImage(":icons/mine.svg"));
+            drawMine = true;
         }
-        else if (m_numNeighboringMines != 0)
+        else if (tile != Revealed)
         {
-            label = QString::number(m_numNeighboringMines);
-            painter.setPen(Brushes::labelColors[m_numNeighboringMines]);
+            int numNeighboringMines = tile - Number1 + 1;
+            label = QString::number(numNeighboringMines);
+            painter.setPen(Brushes::labelColors[numNeighboringMines]);
         }
     }
     else
@@ -212,7 +135,7 @@ void Cell::paintEvent(QPaintEvent* event)
         lowlight.lineTo(bottomLeftIn);
         lowlight.lineTo(bottomLeftOut);
 
-        if (m_leftMouseDown)
+        if (tile == Pressed)
         {
             painter.fillRect(rect, Brushes::DarkerBackground);
             painter.fillPath(highlight, Brushes::DarkBackground);
@@ -225,26 +148,22 @@ void Cell::paintEvent(QPaintEvent* event)
             painter.fillPath(lowlight, Brushes::DarkBackground);
         }
 
-        if (m_flagged)
-        {
-            QString label = QStringLiteral("F");
-            QFontMetrics fm = painter.fontMetrics();
-            QRect br = fm.tightBoundingRect(label);
-            QPoint labelStart(
-                rect.center().x() - round(br.width() / 2.0),
-                rect.center().y() + round(br.height() / 2.0));
-
-            painter.drawText(labelStart, label);
-        }
-
-        if (m_gameOver && isMine())
+        if (tile == Flag)
         {
+            label = QStringLiteral("F");
             painter.setPen(Qt::black);
-            painter.drawImage(mineRect, QImage(":icons/mine.svg"));
         }
+
+        drawMine = tile == Mine;
+    }
+
+    if (drawMine)
+    {
+        QSvgRenderer svg(QStringLiteral(":icons/mine.svg"));
+        svg.render(&painter, mineRect);
     }
 
-    if (label != "")
+    if (!label.isEmpty())
     {
         QFontMetrics fm = painter.fontMetrics();
         QRect br = fm.tightBoundingRect(label);
@@ -260,4 +179,7 @@ void Cell::paintEvent(QPaintEvent* event)
     painter.drawLine(rect.topRight(), rect.bottomRight());
     painter.drawLine(rect.bottomRight(), rect.bottomLeft());
     painter.drawLine(rect.bottomLeft(), rect.topLeft());
+
+    painter.end();
+    m_tiles[tile] = pixmap;
 }
@@ -0,0 +1,75 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TILEATLAS_H
+#define TILEATLAS_H
+
+#include <QFont>
+#include <QPixmap>
+#include <QSize>
+
+#include <array>
+
+/**
+ * @brief Pre-rendered pixmaps for every way a cell can look.
+ *
+ * Tiles are rasterized once for a given cell size, device pixel ratio and
+ * font, so painting a cell is a single pixmap blit.
+ */
+class TileAtlas
+{
+public:
+    enum Tile
+    {
+        Raised,
+        Pressed,
+        Flag,
+        Mine,          // an unrevealed mine, shown once the game is over
+        ExplodedMine,  // a revealed mine
+        Revealed,      // a revealed cell with no neighboring mines
+        Number1,       // Number1 + (n - 1) is a revealed cell with n neighboring mines
+        Number8 = Number1 + 7,
+
+        TileCount
+    };
+
+    static Tile numberTile(int numNeighboringMines)
+    {
+        return numNeighboringMines == 0
+            ? Revealed
+            : static_cast<Tile>(Number1 + numNeighboringMines - 1);
+    }
+
+    /**
+     * @brief Re-renders every tile if any of the given parameters differ from
+     *        those the current tiles were rendered with.
+     */
+    void prepare(QSize cellSize, qreal devicePixelRatio, const QFont& font);
+
+    const QPixmap& tile(Tile tile) const { return m_tiles[tile]; }
+
+private:
+    void render();
+    void renderTile(Tile tile);
+
+    QSize m_cellSize;
+    qreal m_devicePixelRatio{};
+    QFont m_font;
+    std::array<QPixmap, TileCount> m_tiles;
+};
+
+#endif // TILEATLAS_H
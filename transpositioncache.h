@@ -0,0 +1,170 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef TRANSPOSITIONCACHE_H
+#define TRANSPOSITIONCACHE_H
+
+#include <QtGlobal>
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * @brief A thread-safe cache of results keyed by 64-bit hashes, such as
+ *        Zobrist keys, holding at most a given number of bytes.
+ *
+ * Like a chess engine's transposition table, each key has a single entry,
+ * and a new one simply replaces whatever was there.  Each entry is charged
+ * the bytes its inserter says it holds, and once they add up to more than
+ * the budget, the least recently used entries are evicted until they fit.
+ * Values are held by shared pointer, so a hit costs no copy and stays valid
+ * after eviction.
+ *
+ * Since different values can share a key, lookups take a predicate that
+ * confirms a candidate really is the value wanted.
+ */
+template <typename Value>
+class TranspositionCache
+{
+public:
+    struct Stats
+    {
+        qint64 lookups{};
+        qint64 hits{};
+        qint64 evictions{};
+        qsizetype bytes{};
+
+        double hitRate() const { return lookups > 0 ? static_cast<double>(hits) / lookups : 0.0; }
+    };
+
+    /**
+     * @param maxBytes the most bytes that the entries may be charged in all.
+     */
+    explicit TranspositionCache(qsizetype maxBytes)
+        : m_maxBytes{maxBytes}
+    {
+    }
+
+    /**
+     * @brief Returns the value stored under the given key, if there is one and
+     *        matches(value) confirms it; otherwise null.
+     */
+    template <typename Matches>
+    std::shared_ptr<const Value> find(std::uint64_t key, Matches&& matches)
+    {
+        std::shared_ptr<const Value> value;
+        {
+            std::lock_guard lock{m_mutex};
+            ++m_stats.lookups;
+
+            const auto it = m_index.find(key);
+            if (it == m_index.end())
+            {
+                return nullptr;
+            }
+            value = it->second->value;
+        }
+
+        if (!matches(*value))
+        {
+            return nullptr;
+        }
+
+        std::lock_guard lock{m_mutex};
+        ++m_stats.hits;
+
+        // The entry may have been replaced or evicted while it was compared.
+        const auto it = m_index.find(key);
+        if (it != m_index.end() && it->second->value == value)
+        {
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+        }
+        return value;
+    }
+
+    /**
+     * @param bytes what the value holds, counting everything it owns; the
+     *        cache adds its own bookkeeping.  A value larger than the whole
+     *        budget is not kept at all.
+     */
+    void insert(std::uint64_t key, std::shared_ptr<const Value> value, qsizetype bytes)
+    {
+        std::lock_guard lock{m_mutex};
+        if (const auto it = m_index.find(key); it != m_index.end())
+        {
+            m_stats.bytes -= it->second->bytes;
+            m_entries.erase(it->second);
+            m_index.erase(it);
+        }
+        if (bytes + kEntryOverhead > m_maxBytes)
+        {
+            return;
+        }
+
+        bytes += kEntryOverhead;
+        m_entries.push_front(Entry{key, std::move(value), bytes});
+        m_index.emplace(key, m_entries.begin());
+        m_stats.bytes += bytes;
+
+        while (m_stats.bytes > m_maxBytes)
+        {
+            const Entry& oldest = m_entries.back();
+            m_stats.bytes -= oldest.bytes;
+            ++m_stats.evictions;
+            m_index.erase(oldest.key);
+            m_entries.pop_back();
+        }
+    }
+
+    Stats stats() const
+    {
+        std::lock_guard lock{m_mutex};
+        return m_stats;
+    }
+
+    void clear()
+    {
+        std::lock_guard lock{m_mutex};
+        m_entries.clear();
+        m_index.clear();
+        m_stats = {};
+    }
+
+private:
+    struct Entry
+    {
+        std::uint64_t key{};
+        std::shared_ptr<const Value> value;
+        qsizetype bytes{};
+    };
+
+    // What each entry costs beyond its value: a list node with its two links,
+    // and an index node holding the key, the iterator, a link and a bucket.
+    static constexpr qsizetype kEntryOverhead = sizeof(Entry) + 2 * sizeof(void*)
+                                                + sizeof(std::uint64_t) + 3 * sizeof(void*);
+
+    mutable std::mutex m_mutex;
+    qsizetype m_maxBytes;
+    std::list<Entry> m_entries; // most recently used first
+    std::unordered_map<std::uint64_t, typename std::list<Entry>::iterator> m_index;
+    Stats m_stats;
+};
+
+#endif // TRANSPOSITIONCACHE_H
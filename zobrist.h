@@ -0,0 +1,65 @@
+// Mines
+//
+// Copyright (C) 2024 Benjamin Bader
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <cstdint>
+
+/**
+ * @brief Zobrist keys: a pseudo-random 64-bit key for each feature a cell can
+ *        have, so that a set of features hashes to the XOR of their keys and
+ *        adding or removing one feature updates the hash in constant time.
+ *
+ * Keys are computed from the cell and the feature rather than looked up in a
+ * table, so they cost no memory, are the same for every board, and never
+ * need to be initialized.
+ */
+namespace Zobrist
+{
+
+enum Feature : std::uint32_t
+{
+    Number0,             // a revealed cell; Number0 + n for n neighboring mines
+    RevealedMine = 9,
+    Flag,
+    Unknown,             // an unknown cell of a constraint problem
+    Constrained,         // a cell covered by one particular constraint
+    ConstraintMines,     // keyed by a constraint's mine count rather than a cell
+    Solved,              // a position seen through a solver's deductions; keyed by cell 0
+
+    FeatureCount
+};
+
+/**
+ * @brief The splitmix64 finalizer; a bijection, so distinct inputs never collide.
+ */
+inline std::uint64_t mix(std::uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+inline std::uint64_t key(int cell, Feature feature)
+{
+    return mix((static_cast<std::uint64_t>(static_cast<std::uint32_t>(cell)) * FeatureCount + feature) + 0x9e3779b97f4a7c15ULL);
+}
+
+} // namespace Zobrist
+
+#endif // ZOBRIST_H